@@ -1,56 +1,267 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <tuple>
 
-#include "../press.h"
 #include "benchmark.h"
 
-int main()
+// a custom type with the allocating to_string interface
+struct stamp
 {
-	constexpr int loops = 1000000;
+	long long t;
+};
 
-	for(int i = 0; i < loops; ++i)
+namespace press
+{
+	std::string to_string(const stamp &s)
+	{
+		return "t=" + std::to_string(s.t);
+	}
+}
+
+#include "../press.hpp"
+
+#ifdef PRESS_BENCH_FMT
+#include <fmt/format.h>
+#endif
+
+// a custom type that formats straight into the Writer
+struct order_id
+{
+	unsigned long long id;
+};
+
+namespace press
+{
+	void format_to(press::Writer &writer, const order_id &o, const press::Format &format)
+	{
+		writer.write("ORD-", 4);
+		press::Converter::integer(writer, o.id, format, -1);
+	}
+}
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+double bench::duration = 0.2;
+const char *bench::filter = NULL;
+
+static char buffer[1024];
+
+// times one formatting expression that returns its length, and hands the output to another translation unit
+#define BENCH(group, name, ...) \
+	bench::run(group, name, [&]() -> int { const int length = (__VA_ARGS__); consume(buffer, length); return length; })
+
+#ifdef PRESS_BENCH_FMT
+#define BENCH_FMT(group, name, ...) \
+	BENCH(group, name, (int)fmt::format_to_n(buffer, sizeof(buffer), __VA_ARGS__).size)
+#else
+#define BENCH_FMT(group, name, ...)
+#endif
+
+static void converters(const data &d)
+{
+	const order_id order{d.houses};
+	const stamp when{d.sandwiches};
+
+	BENCH("int", "press", press::bprint(buffer, sizeof(buffer), "{}", d.age));
+	BENCH("int", "press compiled", press::bprint(buffer, sizeof(buffer), prcompile("{}"), d.age));
+	BENCH("int", "snprintf", snprintf(buffer, sizeof(buffer), "%d", d.age));
+	BENCH_FMT("int", "fmt", "{}", d.age);
+
+	BENCH("int64", "press", press::bprint(buffer, sizeof(buffer), "{}", d.sandwiches));
+	BENCH("int64", "snprintf", snprintf(buffer, sizeof(buffer), "%lld", d.sandwiches));
+	BENCH_FMT("int64", "fmt", "{}", d.sandwiches);
+
+	BENCH("hex", "press", press::bprint(buffer, sizeof(buffer), "{x}", d.houses * 0x9e3779b97f4aULL));
+	BENCH("hex", "snprintf", snprintf(buffer, sizeof(buffer), "%llx", d.houses * 0x9e3779b97f4aULL));
+	BENCH_FMT("hex", "fmt", "{:x}", d.houses * 0x9e3779b97f4aULL);
+
+	BENCH("hex", "press pointer {#}", press::bprint(buffer, sizeof(buffer), "{#}", (const void*)&d));
+	BENCH("hex", "snprintf %p", snprintf(buffer, sizeof(buffer), "%p", (const void*)&d));
+	BENCH("hex", "press hexdump 64 bytes", press::bprint(buffer, sizeof(buffer), "{}", press::hexdump(&d, 64)));
+	BENCH("hex", "snprintf loop 64 bytes", [&]()
 	{
-		const data d = get_data();
+		const unsigned char *bytes = (const unsigned char*)&d;
+		for(int i = 0; i < 64; ++i)
+			snprintf(buffer + i * 2, 3, "%02x", bytes[i]);
+		return 128;
+	}());
+
+	BENCH("oct", "press", press::bprint(buffer, sizeof(buffer), "{o}", d.houses * 0x9e3779b97f4aULL));
+	BENCH("oct", "snprintf", snprintf(buffer, sizeof(buffer), "%llo", d.houses * 0x9e3779b97f4aULL));
+	BENCH_FMT("oct", "fmt", "{:o}", d.houses * 0x9e3779b97f4aULL);
+
+	BENCH("float", "press {}", press::bprint(buffer, sizeof(buffer), "{}", d.price));
+	BENCH("float", "snprintf %f", snprintf(buffer, sizeof(buffer), "%f", d.price));
+	BENCH_FMT("float", "fmt {:f}", "{:f}", d.price);
+	BENCH("float", "press {.2}", press::bprint(buffer, sizeof(buffer), "{.2}", d.price));
+	BENCH("float", "snprintf %.2f", snprintf(buffer, sizeof(buffer), "%.2f", d.price));
+	BENCH_FMT("float", "fmt {:.2f}", "{:.2f}", d.price);
+	BENCH("float", "press {e.6}", press::bprint(buffer, sizeof(buffer), "{e.6}", d.price));
+	BENCH("float", "snprintf %.6e", snprintf(buffer, sizeof(buffer), "%.6e", d.price));
+	BENCH_FMT("float", "fmt {:.6e}", "{:.6e}", d.price);
+	BENCH("float", "press {g}", press::bprint(buffer, sizeof(buffer), "{g}", d.price));
+	BENCH("float", "snprintf %.17g", snprintf(buffer, sizeof(buffer), "%.17g", d.price));
+	BENCH_FMT("float", "fmt {}", "{}", d.price);
+
+	BENCH("string", "press const char*", press::bprint(buffer, sizeof(buffer), "{}", d.name));
+	BENCH("string", "press std::string", press::bprint(buffer, sizeof(buffer), "{}", d.city));
+	BENCH("string", "snprintf %s", snprintf(buffer, sizeof(buffer), "%s", d.name));
+	BENCH_FMT("string", "fmt", "{}", d.name);
+
+	BENCH("custom", "press format_to", press::bprint(buffer, sizeof(buffer), "{}", order));
+	BENCH("custom", "press to_string", press::bprint(buffer, sizeof(buffer), "{}", when));
+	BENCH("custom", "snprintf", snprintf(buffer, sizeof(buffer), "ORD-%llu", order.id));
 
-		BENCH_START("Press");
-		char buffer[2048];
-		prbwrite(buffer, sizeof(buffer), "Hello, my name is {}, I am {} years old, I have {} children, {} houses, and {} sandwiches.", d.name, d.age, d.children, d.houses, d.sandwiches);
-		BENCH_STOP("Press");
+	BENCH("padding", "press {10} {-10} {010}", press::bprint(buffer, sizeof(buffer), "{10} {-10} {010}", d.age, d.children, d.sandwiches));
+	BENCH("padding", "snprintf", snprintf(buffer, sizeof(buffer), "%10d %-10u %010lld", d.age, d.children, d.sandwiches));
+	BENCH_FMT("padding", "fmt", "{:>10} {:<10} {:010}", d.age, d.children, d.sandwiches);
 
-		process(buffer);
+	BENCH("separator", "press {,}", press::bprint(buffer, sizeof(buffer), "{,}", d.sandwiches));
+	BENCH("separator", "snprintf %'lld", snprintf(buffer, sizeof(buffer), "%'lld", d.sandwiches));
+
+	BENCH("mixed", "press", press::bprint(buffer, sizeof(buffer), "Hello, my name is {}, I am {} years old, I have {} children, {} houses, and {} sandwiches.", d.name, d.age, d.children, d.houses, d.sandwiches));
+	BENCH("mixed", "press compiled", press::bprint(buffer, sizeof(buffer), prcompile("Hello, my name is {}, I am {} years old, I have {} children, {} houses, and {} sandwiches."), d.name, d.age, d.children, d.houses, d.sandwiches));
+	BENCH("mixed", "snprintf", snprintf(buffer, sizeof(buffer), "Hello, my name is %s, I am %d years old, I have %u children, %llu houses, and %lld sandwiches.", d.name, d.age, d.children, d.houses, d.sandwiches));
+	BENCH_FMT("mixed", "fmt", "Hello, my name is {}, I am {} years old, I have {} children, {} houses, and {} sandwiches.", d.name, d.age, d.children, d.houses, d.sandwiches);
+	BENCH("mixed", "ostringstream", [&]()
+	{
+		std::ostringstream ss;
+		ss << "Hello, my name is " << d.name << ", I am " << d.age << " years old, I have " << d.children << " children, " << d.houses << " houses, and " << d.sandwiches << " sandwiches.";
+		return (int)ss.str().size();
+	}());
+}
+
+static void targets(const data &d)
+{
+	FILE *fp = fopen(NULL_DEVICE, "w");
+	if(fp == NULL)
+	{
+		fprintf(stderr, "error: couldn't open " NULL_DEVICE "\n");
+		exit(1);
 	}
 
-	for(int i = 0; i < loops; ++i)
+	std::string reused;
+
+	BENCH("target", "BUFFER bprint", press::bprint(buffer, sizeof(buffer), "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches));
+	BENCH("target", "BUFFER snprintf", snprintf(buffer, sizeof(buffer), "%s has %llu houses and %lld sandwiches", d.name, d.houses, d.sandwiches));
+	BENCH("target", "STDSTRING sprint", (int)press::sprint("{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches).size());
+	BENCH("target", "STDSTRING sprint_into", (reused.clear(), press::sprint_into(reused, "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches), (int)reused.size()));
+	std::vector<char> chars;
+	BENCH("target", "STDSTRING format_to vector", (chars.clear(), press::format_to(chars, "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches)));
+	BENCH("target", "SINK format_to iterator", (chars.clear(), press::format_to(std::back_inserter(chars), "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches), (int)chars.size()));
+	BENCH("target", "COUNT formatted_size", press::formatted_size("{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches));
+	BENCH("target", "FILE_P fprintln", press::fprintln(fp, "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches));
+	BENCH("target", "FILE_P fprintf", fprintf(fp, "%s has %llu houses and %lld sandwiches\n", d.name, d.houses, d.sandwiches));
 	{
-		const data d = get_data();
+		press::buffered_stream stream(fp);
+		BENCH("target", "buffered_stream println", stream.println("{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches));
+	}
+#ifdef PRESS_HAS_FD
+	const int fd = fileno(fp);
+	BENCH("target", "FD dprintln", press::dprintln(fd, "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches));
+	BENCH("target", "FD dprintf", dprintf(fd, "%s has %llu houses and %lld sandwiches\n", d.name, d.houses, d.sandwiches));
+#endif
+
+	fclose(fp);
+}
 
-		BENCH_START("Printf");
-		char buffer[2048];
-		snprintf(buffer, sizeof(buffer), "Hello, my name is %s, I am %d years old, I have %u children, %llu houses, and %lld sandwiches.", d.name, d.age, d.children, d.houses, d.sandwiches);
-		BENCH_STOP("Printf");
+static void argument_counts(const data &d)
+{
+	const int a = d.age;
 
-		process(buffer);
+	BENCH("arguments", "press 1", press::bprint(buffer, sizeof(buffer), "{}", a));
+	BENCH("arguments", "snprintf 1", snprintf(buffer, sizeof(buffer), "%d", a));
+	BENCH("arguments", "press 4", press::bprint(buffer, sizeof(buffer), "{} {} {} {}", a, a, a, a));
+	BENCH("arguments", "snprintf 4", snprintf(buffer, sizeof(buffer), "%d %d %d %d", a, a, a, a));
+	press::dynamic_args args;
+	BENCH("arguments", "press dynamic_args 4", (args.clear(), args.push_back(a), args.push_back(a), args.push_back(a), args.push_back(a), press::vbprint(buffer, sizeof(buffer), "{} {} {} {}", args)));
+	BENCH("arguments", "press 8", press::bprint(buffer, sizeof(buffer), "{} {} {} {} {} {} {} {}", a, a, a, a, a, a, a, a));
+	BENCH("arguments", "snprintf 8", snprintf(buffer, sizeof(buffer), "%d %d %d %d %d %d %d %d", a, a, a, a, a, a, a, a));
+	BENCH("arguments", "press 16", press::bprint(buffer, sizeof(buffer), "{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {}", a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a));
+	BENCH("arguments", "snprintf 16", snprintf(buffer, sizeof(buffer), "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d", a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a));
+	BENCH("arguments", "press 24", press::bprint(buffer, sizeof(buffer), "{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {}", a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a));
+	BENCH("arguments", "snprintf 24", snprintf(buffer, sizeof(buffer), "%d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d %d", a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a, a));
+}
+
+static void contention(const data &d)
+{
+	FILE *fp = fopen(NULL_DEVICE, "w");
+	if(fp == NULL)
+	{
+		fprintf(stderr, "error: couldn't open " NULL_DEVICE "\n");
+		exit(1);
 	}
 
-	for(int i = 0; i < loops; ++i)
+	static const int counts[] = {1, 2, 4, 8};
+	for(const int threads : counts)
 	{
-		const data d = get_data();
+		char name[64];
+		snprintf(name, sizeof(name), "press fprintln x%d", threads);
+		bench::run_threads("threads", name, threads, [&]() { return press::fprintln(fp, "{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches); });
+
+		snprintf(name, sizeof(name), "press thread_stream x%d", threads);
+		bench::run_threads("threads", name, threads, [&]() { return press::thread_stream(fp).println("{} has {} houses and {} sandwiches", d.name, d.houses, d.sandwiches); });
+
+		snprintf(name, sizeof(name), "fprintf x%d", threads);
+		bench::run_threads("threads", name, threads, [&]() { return fprintf(fp, "%s has %llu houses and %lld sandwiches\n", d.name, d.houses, d.sandwiches); });
+	}
+
+	fclose(fp);
+}
+
+#ifdef PRESS_PARALLEL
+static void batches(const data &d)
+{
+	std::vector<std::tuple<int, std::string, double>> records;
+	for(int i = 0; i < 100000; ++i)
+		records.emplace_back(d.age + i, d.city, d.price * i);
 
-		BENCH_START("Cout");
-		std::ostringstream buffer;
-		buffer << "Hello, my name is " << d.name << ", I am " << d.age << " years old, I have " << d.children << " children, " << d.houses << " houses, and " << d.sandwiches << " sandwiches.";
-		BENCH_STOP("Cout");
+	std::string output;
+	BENCH("batch", "press sequential 100k records", (output.clear(), [&]()
+	{
+		for(size_t i = 0; i < records.size(); ++i)
+			press::format_to(output, "{},{},{.2}\n", std::get<0>(records[i]), std::get<1>(records[i]), std::get<2>(records[i]));
+		return (int)output.size();
+	}()));
+	BENCH("batch", "press parallel_format 100k records", (output.clear(), (int)press::parallel_format(output, "{},{},{.2}\n", records)));
+}
+#endif
 
-		process(buffer);
+// usage: press-benchmark [--quick] [filter], where filter selects groups or cases containing it, e.g. "float" or "snprintf"
+int main(int argc, char **argv)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		if(!strcmp(argv[i], "--quick"))
+			bench::duration = 0.02;
+		else
+			bench::filter = argv[i];
 	}
 
-	printf("------------------------------------------\n");
-	BENCH_SHOW("Press");
-	BENCH_SHOW("Printf");
-	BENCH_SHOW("Cout");
-	printf("------------------------------------------\n");
+	const data d = get_data();
+
+	// make sure the numbers mean something
+	press::bprint(buffer, sizeof(buffer), "Hello, my name is {}, I am {} years old, I have {} children, {} houses, and {} sandwiches.", d.name, d.age, d.children, d.houses, d.sandwiches);
+	process(buffer);
+
+	printf("%-10s %-34s %16s %15s\n", "group", "case", "time", "throughput");
+	printf("--------------------------------------------------------------------------------\n");
+	converters(d);
+	targets(d);
+	argument_counts(d);
+	contention(d);
+#ifdef PRESS_PARALLEL
+	batches(d);
+#endif
+	printf("--------------------------------------------------------------------------------\n");
 
 	return 0;
 }
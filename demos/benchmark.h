@@ -1,29 +1,16 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
-#include <unordered_map>
+#include <algorithm>
 #include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <sstream>
 #include <stdio.h>
+#include <string.h>
 
-std::unordered_map<const char*, std::chrono::time_point<std::chrono::high_resolution_clock>> starts;
-std::unordered_map<const char*, unsigned long long> times;
-
-#define BENCH_START(x) \
-	if(times.find(x) == times.end()) \
-	{ \
-		times[x] = 0; \
-	} \
-	starts[x] = std::chrono::high_resolution_clock::now();
-
-#define BENCH_STOP(x) \
-	{ \
-		const std::chrono::time_point<std::chrono::high_resolution_clock> benchmark_end_time_ = std::chrono::high_resolution_clock::now(); \
-		times[x] += (unsigned long long)std::chrono::duration<double, std::nano>(benchmark_end_time_ - starts[x]).count(); \
-	}
-
-#define BENCH_SHOW(x) \
-	printf("benchmark \"" x "\" took %llu microseconds\n", times[x] / 1000);
-
+// the inputs come from, and the outputs go to, another translation unit, so the compiler can't fold or discard the formatting
 struct data
 {
 	const char *name;
@@ -31,10 +18,94 @@ struct data
 	unsigned children;
 	unsigned long long houses;
 	long long sandwiches;
+	double price;
+	std::string city;
 };
 
 data get_data();
 void process(const char*);
 void process(const std::ostringstream&);
+void consume(const char *buffer, int length);
+
+namespace bench
+{
+	typedef std::chrono::steady_clock clock;
+
+	// seconds each case is run for, after one warm up call
+	extern double duration;
+	extern const char *filter;
+
+	inline bool selected(const char *group, const char *name)
+	{
+		return filter == NULL || strstr(group, filter) != NULL || strstr(name, filter) != NULL;
+	}
+
+	inline void report(const char *group, const char *name, double seconds, unsigned long long ops, unsigned long long bytes)
+	{
+		printf("%-10s %-34s %10.1f ns/op %10.1f MB/s\n", group, name, seconds * 1e9 / ops, bytes / seconds / 1e6);
+		fflush(stdout);
+	}
+
+	// time f, which formats one call and returns the number of bytes it produced, in batches for at least duration seconds
+	template <typename F> void run(const char *group, const char *name, F f)
+	{
+		if(!selected(group, name))
+			return;
+
+		// batches start small and double, so that slow cases (whole batches of records) don't run for minutes
+		static const int MAX_BATCH = 1000;
+		unsigned long long ops = 0;
+		unsigned long long bytes = 0;
+		f();
+
+		const clock::time_point start = clock::now();
+		double seconds = 0;
+		int batch = 1;
+		do
+		{
+			for(int i = 0; i < batch; ++i)
+				bytes += f();
+
+			ops += batch;
+			batch = std::min(batch * 2, MAX_BATCH);
+			seconds = std::chrono::duration<double>(clock::now() - start).count();
+		} while(seconds < duration);
+
+		report(group, name, seconds, ops, bytes);
+	}
+
+	// run f on each of thread_count threads at once, ns/op is the wall time over every thread's calls
+	template <typename F> void run_threads(const char *group, const char *name, int thread_count, F f)
+	{
+		if(!selected(group, name))
+			return;
+
+		const unsigned long long per_thread = (unsigned long long)(duration * 2e6 / thread_count) + 1;
+		std::vector<unsigned long long> bytes(thread_count, 0);
+		std::vector<std::thread> threads;
+
+		const clock::time_point start = clock::now();
+		for(int t = 0; t < thread_count; ++t)
+		{
+			threads.emplace_back([&, t]()
+			{
+				unsigned long long total = 0;
+				for(unsigned long long i = 0; i < per_thread; ++i)
+					total += f();
+
+				bytes[t] = total;
+			});
+		}
+
+		unsigned long long total = 0;
+		for(int t = 0; t < thread_count; ++t)
+		{
+			threads[t].join();
+			total += bytes[t];
+		}
+
+		report(group, name, std::chrono::duration<double>(clock::now() - start).count(), per_thread * thread_count, total);
+	}
+}
 
 #endif // BENCHMARK_H
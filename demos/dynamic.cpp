@@ -5,18 +5,11 @@
 #include <string.h>
 #include <stdlib.h>
 
-struct data
-{
-	const char *name;
-	int age;
-	unsigned children;
-	unsigned long long houses;
-	long long sandwiches;
-};
+#include "benchmark.h"
 
 data get_data()
 {
-	return {"joe biden", 47, 33, 78, -111222558};
+	return {"joe biden", 47, 33, 78, -111222558, 1234.5678, "washington"};
 }
 
 void process(const char *str)
@@ -33,3 +26,11 @@ void process(const std::ostringstream &ss)
 {
 	process(ss.str().c_str());
 }
+
+volatile char consumed;
+
+void consume(const char *buffer, int length)
+{
+	if(length > 0)
+		consumed = buffer[0];
+}
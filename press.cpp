@@ -0,0 +1,4 @@
+// the type-erased core of press, for builds with PRESS_HEADER_ONLY=0 (the press library in CMakeLists.txt). compile this
+// with the same PRESS_* flags as the code that uses it
+#define PRESS_IMPLEMENTATION
+#include "press.hpp"
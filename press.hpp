@@ -5,12 +5,105 @@
 #include <memory>
 #include <string>
 #include <tuple>
-
+#include <iterator>
+#include <algorithm>
+#include <vector>
+
+#if __cplusplus >= 201703L || (defined (_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define PRESS_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
+// loops in constexpr functions, used by the compile time format string checks
+#if __cplusplus >= 201402L || (defined (_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#define PRESS_HAS_CONSTEXPR_LOOPS
+#endif
+
+// with PRESS_HEADER_ONLY=0 the type-erased core (Writer, Parameter::convert, format compilation and the printers) is only
+// declared here, and compiled once into the press library from press.cpp, which defines PRESS_IMPLEMENTATION
+#ifndef PRESS_HEADER_ONLY
+#define PRESS_HEADER_ONLY 1
+#endif
+
+#if PRESS_HEADER_ONLY
+#define PRESS_CORE inline
+#define PRESS_CORE_DEFINITIONS
+#else
+#define PRESS_CORE
+#ifdef PRESS_IMPLEMENTATION
+#define PRESS_CORE_DEFINITIONS
+#endif
+#endif
+
+#include <atomic>
+
+#ifdef PRESS_ASYNC
+#include <thread>
+#include <chrono>
+#endif
+
+#ifdef PRESS_STATS
+#include <chrono>
+#endif
+
+#ifdef PRESS_PARALLEL
+#include <thread>
+#endif
+
+// vectorized scanning of format strings for '{' and hex conversion, define PRESS_NO_SIMD to use the plain loops
+#ifndef PRESS_NO_SIMD
+#if defined (__AVX2__)
+#define PRESS_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PRESS_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (_M_ARM64)
+#define PRESS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#if defined (_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#include <stdint.h>
 #include <string.h>
 #include <limits.h>
 #include <locale.h>
 #include <stdio.h>
 
+// raw file descriptor target, press::dprint
+#if defined (__unix__) || defined (__APPLE__)
+#define PRESS_HAS_FD
+#include <unistd.h>
+#include <sys/uio.h>
+#include <errno.h>
+#endif
+
+// a FILE* is locked once for each print call so that its output (including the newline for println) is never interleaved
+// with output from other threads, and the writes in between don't lock it again. define PRESS_NO_FILE_LOCK to disable
+#ifndef PRESS_NO_FILE_LOCK
+#if defined (_WIN32)
+#define PRESS_LOCK_FILE(fp) _lock_file(fp)
+#define PRESS_UNLOCK_FILE(fp) _unlock_file(fp)
+#define PRESS_FWRITE(buf, count, fp) _fwrite_nolock(buf, 1, count, fp)
+#elif defined (__unix__) || defined (__APPLE__)
+#define PRESS_LOCK_FILE(fp) flockfile(fp)
+#define PRESS_UNLOCK_FILE(fp) funlockfile(fp)
+#if defined (__GLIBC__) && defined (_GNU_SOURCE)
+#define PRESS_FWRITE(buf, count, fp) fwrite_unlocked(buf, 1, count, fp)
+#endif
+#else
+#define PRESS_NO_FILE_LOCK
+#endif
+#endif
+
+#ifndef PRESS_FWRITE
+#define PRESS_FWRITE(buf, count, fp) fwrite(buf, 1, count, fp)
+#endif
+
 /* PRESS printing tool
 
 Press is a printing tool for human-readable output using printf style syntax, but with extra type
@@ -24,44 +117,115 @@ refer to README.md to read about features and interfaces
 	static_assert(press::is_balanced(fmt, press::string_length(fmt)), "press: specifier brackets are not balanced!"); \
 	static_assert(press::count_specifiers(fmt, press::string_length(fmt)) >= count, "press: too many parameters!")
 
+// pressfmtcheck plus a full parse of every specifier against the parameter types, args is the std::tuple of the parameters
+#define pressfmtcheck_args(fmt, args) \
+	pressfmtcheck(fmt, std::tuple_size<args>::value); \
+	static_assert(press::impl::check_format<press::impl::tuple_kinds<args>>(fmt, press::string_length(fmt), std::tuple_size<args>::value) != press::impl::CHECK_MALFORMED, "press: malformed specifier! flags go in the order: fill and alignment, sign, separator, padding, #, representation, width, precision, index"); \
+	static_assert(press::impl::check_format<press::impl::tuple_kinds<args>>(fmt, press::string_length(fmt), std::tuple_size<args>::value) != press::impl::CHECK_INDEX, "press: specifier refers to a parameter that doesn't exist!"); \
+	static_assert(press::impl::check_format<press::impl::tuple_kinds<args>>(fmt, press::string_length(fmt), std::tuple_size<args>::value) != press::impl::CHECK_TYPE, "press: representation flag doesn't suit the parameter type!")
+
+// compile a format string literal once per call site, the printing macros below use this so that every call
+// after the first one skips all format string parsing
+#define prcompile(fmt) \
+	([]() -> const press::compiled_format& { static const press::compiled_format_storage<press::count_segments(fmt, press::string_length(fmt))> compiled_fmt(fmt, false, true); return compiled_fmt; }())
+
+// the same, but marked as trusted: only for formats that went through pressfmtcheck_args with the parameters they're printed with,
+// which lets impl::printer skip its runtime index checks
+#define prcompile_trusted(fmt) \
+	([]() -> const press::compiled_format& { static const press::compiled_format_storage<press::count_segments(fmt, press::string_length(fmt))> compiled_fmt(fmt, true, true); return compiled_fmt; }())
+
+// the call comes before the checks so that the macros can be used as expressions, e.g. const int len = prbprint(...);
+
 #define prprint(fmt, ...) \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value); \
-	press::impl::write(press::PrintTarget::FILE_P, stdout, NULL, NULL, 0u, fmt, ##__VA_ARGS__)
+	press::print(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prprintln(fmt, ...) \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value); \
-	press::println(fmt, ##__VA_ARGS__)
+	press::println(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prfprint(fp, fmt, ...) \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value); \
-	press::impl::write(press::PrintTarget::FILE_P, fp, NULL, NULL, 0u, fmt, ##__VA_ARGS__)
+	press::fprint(fp, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prfprintln(fp, fmt, ...) \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value); \
-	press::fprintln(fp, fmt, ##__VA_ARGS__)
+	press::fprintln(fp, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prbprint(userbuffer, size, fmt, ...) \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value); \
-	press::impl::write(press::PrintTarget::BUFFER, NULL, NULL, userbuffer, size, fmt, ##__VA_ARGS__)
+	press::bprint(userbuffer, size, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prbprintln(userbuffer, size, fmt, ...) \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value); \
-	press::bprintln(userbuffer, size, fmt, ##__VA_ARGS__)
+	press::bprintln(userbuffer, size, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define prdprint(fd, fmt, ...) \
+	press::dprint(fd, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define prdprintln(fd, fmt, ...) \
+	press::dprintln(fd, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define praprint(fmt, ...) \
+	press::aprint(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define praprintln(fmt, ...) \
+	press::aprintln(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define prafprint(fp, fmt, ...) \
+	press::afprint(fp, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define prafprintln(fp, fmt, ...) \
+	press::afprintln(fp, prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prsprint(fmt, ...) \
-	press::sprint(fmt, ##__VA_ARGS__); \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value);
+	press::sprint(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 #define prsprintln(fmt, ...) \
-	press::sprintln(fmt, ##__VA_ARGS__); \
-	pressfmtcheck(fmt, std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value);
+	press::sprintln(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
+
+#define prformatted_size(fmt, ...) \
+	press::formatted_size(prcompile_trusted(fmt), ##__VA_ARGS__); \
+	pressfmtcheck_args(fmt, decltype(std::make_tuple(__VA_ARGS__)));
 
 namespace press
 {
+	#ifdef PRESS_HAS_CONSTEXPR_LOOPS
+	constexpr int string_length(const char *s, int len = 0)
+	{
+		while(s[len] != 0)
+			++len;
+
+		return len;
+	}
+	#else
 	constexpr int string_length(const char *s, int len = 0)
 	{
 		return s[len] == 0 ? len : string_length(s, len + 1);
 	}
+	#endif
+
+	// pointer and length string argument, the length is never recomputed so it may contain embedded NULs
+	struct str_ref
+	{
+		str_ref(const char *s, size_t len) : data(s), length(len) {}
+		str_ref(const char *s) : data(s), length(strlen(s)) {}
+		str_ref(const std::string &s) : data(s.data()), length(s.size()) {}
+	#ifdef PRESS_HAS_STRING_VIEW
+		str_ref(std::string_view s) : data(s.data()), length(s.size()) {}
+	#endif
+
+		const char *data;
+		size_t length;
+	};
 
 	template <typename T> struct width_spec
 	{
@@ -100,11 +264,113 @@ namespace press
 		return width_precision_spec<T>(arg, w, p);
 	}
 
+	// the locale conventions used for numbers. by default a snapshot of the C locale's conventions taken on first use, call
+	// press::refresh_locale() after setlocale() to pick up the new locale, or press::set_locale() to use your own. like
+	// setlocale(), neither should be called while other threads are printing
+	struct locale_info
+	{
+		locale_info() : locale_info('.', ",", "\3") {}
+
+		// grouping is in the same form as lconv::grouping: the size of each group of digits starting from the right, where the
+		// last size repeats, and CHAR_MAX stops any further grouping
+		locale_info(const char point, const char *const separator, const char *const groups)
+			: decimal_point(point)
+		{
+			strncpy(thousands_sep, separator, sizeof(thousands_sep) - 1);
+			thousands_sep[sizeof(thousands_sep) - 1] = 0;
+			strncpy(grouping, groups, sizeof(grouping) - 1);
+			grouping[sizeof(grouping) - 1] = 0;
+			thousands_sep_length = strlen(thousands_sep);
+		}
+
+		// a snapshot of the current C locale, see localeconv()
+		static locale_info current()
+		{
+			const lconv *const lc = localeconv();
+			const char point = *lc->decimal_point;
+
+			// locales without a separator (like "C") get the traditional one for their decimal point, in groups of 3
+			if(*lc->thousands_sep == 0)
+				return locale_info(point, point == ',' ? "." : ",", "\3");
+
+			return locale_info(point, lc->thousands_sep, *lc->grouping == 0 ? "\3" : lc->grouping);
+		}
+
+		char decimal_point;
+		char thousands_sep[5]; // may be a multibyte character
+		int thousands_sep_length;
+		char grouping[8];
+	};
+
+	namespace impl{
+	inline locale_info &cached_locale()
+	{
+		static locale_info info = locale_info::current();
+		return info;
+	}
+	}
+
+	inline const locale_info &get_locale()
+	{
+		return impl::cached_locale();
+	}
+
+	inline void set_locale(const locale_info &info)
+	{
+		impl::cached_locale() = info;
+	}
+
+	inline void refresh_locale()
+	{
+		impl::cached_locale() = locale_info::current();
+	}
+
+	// the bytes of a buffer in hex, see press::hexdump
+	struct hexdump_spec
+	{
+		const unsigned char *data;
+		size_t length;
+		char separator; // between bytes, 0 for none
+	};
+
+	// e.g. press::println("frame: {}", press::hexdump(frame, length, ' ')), with {X} for uppercase digits and a precision
+	// to dump at most that many bytes
+	inline hexdump_spec hexdump(const void *data, const size_t length, const char separator = 0)
+	{
+		return hexdump_spec{(const unsigned char*)data, length, separator};
+	}
+
+	// formats every element of a range with the specifier it is printed with, separated by separator, see press::join
+	template <typename It> struct join_spec
+	{
+		inline join_spec(It f, It l, const char *sep) : first(f), last(l), separator(sep), separator_length(strlen(sep)) {}
+		const It first;
+		const It last;
+		const char *const separator;
+		const int separator_length;
+	};
+
+	// any container or array, e.g. press::print("{.2}", press::join(values, " | "))
+	template <typename C> inline auto join(const C &container, const char *separator = ", ") -> join_spec<decltype(std::begin(container))>
+	{
+		return join_spec<decltype(std::begin(container))>(std::begin(container), std::end(container), separator);
+	}
+
+	template <typename T> inline join_spec<const T*> join(const T *data, const size_t count, const char *separator = ", ")
+	{
+		return join_spec<const T*>(data, data + count, separator);
+	}
+
 	enum class PrintTarget
 	{
 		FILE_P,
 		STDSTRING,
-		BUFFER
+		BUFFER,
+		SINK, // a user type, see press::format_to
+	#ifdef PRESS_HAS_FD
+		FD,
+	#endif
+		COUNT // nothing is written, only the length of the output is measured
 	};
 
 	struct Format
@@ -118,6 +384,18 @@ namespace press
 		{
 			int bookmark = first;
 
+			// consume fill and alignment, the fill is any character other than a brace
+			if(bookmark >= len)
+				return bookmark;
+			if(bookmark + 1 < len && is_align(fmtstring[bookmark + 1]) && fmtstring[bookmark] != '{' && fmtstring[bookmark] != '}')
+			{
+				cfg.fill = fmtstring[bookmark];
+				cfg.set_align(fmtstring[bookmark + 1]);
+				bookmark += 2;
+			}
+			else if(is_align(fmtstring[bookmark]))
+				cfg.set_align(fmtstring[bookmark++]);
+
 			// consume sign flag
 			if(bookmark >= len)
 				return bookmark;
@@ -132,8 +410,7 @@ namespace press
 				return bookmark;
 			if(fmtstring[bookmark] == ',')
 			{
-				const char sep = *localeconv()->decimal_point;
-				cfg.thousands_sep = sep == '.' ? ',' : (sep == ',' ? '.' : ',');
+				cfg.group_thousands = true;
 				++bookmark;
 			}
 
@@ -142,7 +419,8 @@ namespace press
 				return bookmark;
 			if(fmtstring[bookmark] == '0')
 			{
-				if(cfg.thousands_sep == 0)
+				// an explicit alignment pads with its fill character instead
+				if(!cfg.group_thousands && cfg.align == 0)
 					cfg.zero_pad = true;
 				++bookmark;
 			}
@@ -152,6 +430,15 @@ namespace press
 				++bookmark;
 			}
 
+			// consume alternate form flag
+			if(bookmark >= len)
+				return bookmark;
+			if(fmtstring[bookmark] == '#')
+			{
+				cfg.alternate = true;
+				++bookmark;
+			}
+
 			// consume representation flags
 			if(bookmark >= len)
 				return bookmark;
@@ -170,6 +457,16 @@ namespace press
 				cfg.oct = true;
 				++bookmark;
 			}
+			else if(fmtstring[bookmark] == 'g')
+			{
+				cfg.general = true;
+				++bookmark;
+			}
+			else if(fmtstring[bookmark] == 'e')
+			{
+				cfg.scientific = true;
+				++bookmark;
+			}
 
 			// consume width
 			if(bookmark >= len)
@@ -204,14 +501,30 @@ namespace press
 			hex = false;
 			hex_upper = false;
 			oct = false;
+			general = false;
+			scientific = false;
 			leading_space = false;
+			alternate = false;
 			width = -1;
 			precision = -1;
 			index = -1;
-			thousands_sep = 0;
+			group_thousands = false;
+			fill = ' ';
+			align = 0;
+		}
+
+		static bool is_align(const char c)
+		{
+			return c == '<' || c == '>' || c == '^';
 		}
 
 	private:
+		void set_align(const char c)
+		{
+			align = c;
+			left_justify = c == '<';
+		}
+
 		static signed char consume_number(const char *const fmt, int &bookmark, const int len)
 		{
 			unsigned char number = 0;
@@ -234,307 +547,455 @@ namespace press
 		bool hex;
 		bool hex_upper;
 		bool oct;
+		bool general;
+		bool scientific;
 		bool leading_space;
+		bool alternate; // 0x before hex, 0 before octal
 
 		signed char width;
 		signed char precision;
 		signed char index; // starts at 1
-		char thousands_sep;
+		bool group_thousands; // with the separator and grouping from press::get_locale()
+		char fill; // pads the field to its width
+		char align; // '<', '>' or '^' when given, 0 for the default (right, or left with '-')
 	};
 
-	class Writer
+	#ifdef PRESS_STATS
+	// a snapshot of the counters kept when PRESS_STATS is defined, see press::stats()
+	struct statistics
 	{
-	public:
-		static constexpr int WRITER_BUFFER_SIZE = 1024;
-
-		Writer(PrintTarget target, FILE *fp, std::string *stdstr, char *const user_buffer, const int user_buffer_size)
-			: m_target(target)
-			, m_fp(fp)
-			, m_buffer(user_buffer == NULL ? m_automatic_buffer : user_buffer)
-			, m_stdstring(stdstr)
-			, m_bookmark(0)
-			, m_size(user_buffer == NULL ? WRITER_BUFFER_SIZE : user_buffer_size)
-		{}
-		Writer(const Writer&) = delete;
-		Writer(Writer&&) = delete;
-		~Writer()
-		{
-			if(m_target == PrintTarget::BUFFER && m_size > 0)
-				m_buffer[m_bookmark >= m_size ? m_size - 1 : m_bookmark] = 0;
-			else
-				flush();
-		}
+		static constexpr int TARGET_COUNT = (int)PrintTarget::COUNT + 1;
+		static constexpr int LATENCY_BUCKETS = 32;
+
+		unsigned long long calls[TARGET_COUNT]; // indexed by PrintTarget
+		unsigned long long bytes[TARGET_COUNT]; // produced, including any that didn't fit in a user buffer
+		unsigned long long flushes; // writes handed to a FILE* or file descriptor
+		unsigned long long truncations; // PrintTarget::BUFFER calls whose output didn't fit
+		unsigned long long allocations; // std::strings made by to_string overloads for custom types
+		unsigned long long latency[LATENCY_BUCKETS]; // calls that took from 2^i to 2^(i+1) nanoseconds, from the first byte to the last
+	};
 
-		inline void write(const char *const buf, const int count)
-		{
-			const int written = std::min(m_size - m_bookmark, count);
+	namespace impl{
+	struct stats_counters
+	{
+		std::atomic<unsigned long long> calls[statistics::TARGET_COUNT];
+		std::atomic<unsigned long long> bytes[statistics::TARGET_COUNT];
+		std::atomic<unsigned long long> flushes;
+		std::atomic<unsigned long long> truncations;
+		std::atomic<unsigned long long> allocations;
+		std::atomic<unsigned long long> latency[statistics::LATENCY_BUCKETS];
+	};
 
-			memcpy(m_buffer + m_bookmark, buf, written);
-			m_bookmark += written;
+	inline stats_counters &global_stats()
+	{
+		static stats_counters counters{};
+		return counters;
+	}
 
-			if(written < count && flush())
-				write(buf + written, count - written);
-		}
+	// the counters are only statistics, so they don't need to order anything
+	inline void count(std::atomic<unsigned long long> &counter, const unsigned long long amount = 1)
+	{
+		counter.fetch_add(amount, std::memory_order_relaxed);
+	}
 
-	private:
-		inline bool flush()
+	inline void count_latency(unsigned long long nanoseconds)
+	{
+		int bucket = 0;
+		while(nanoseconds > 1 && bucket < statistics::LATENCY_BUCKETS - 1)
 		{
-			if(m_target == PrintTarget::BUFFER)
-				return false;
-			else if(m_target == PrintTarget::STDSTRING)
-			{
-				m_buffer[m_bookmark] = 0;
-				m_stdstring->append(m_buffer);
-			}
-			else
-				fwrite(m_buffer, 1, m_bookmark, m_fp);
-
-			m_bookmark = 0;
-			return true;
+			nanoseconds >>= 1;
+			++bucket;
 		}
 
-		const PrintTarget m_target;
-		FILE *const m_fp; // optional file pointer
-		char *const m_buffer; // interface to either m_automatic_buffer or user provided buffer
-		std::string *m_stdstring; // optional std::string target
-		char m_automatic_buffer[WRITER_BUFFER_SIZE + 1]; // used by print_target::FILEP and STDSTRING
-		int m_bookmark; // first unwritten byte
-		const int m_size; // sizeof buffer pointed to by m_buffer
-	};
+		count(global_stats().latency[bucket]);
+	}
+	}
 
-	class Parameter
+	// counters of every call made so far by every thread
+	inline statistics stats()
 	{
-	public:
-		enum class Type : unsigned char
+		const impl::stats_counters &counters = impl::global_stats();
+		statistics snapshot;
+		for(int i = 0; i < statistics::TARGET_COUNT; ++i)
 		{
-			NONE,
-			FLOAT64,
-			SIGNED_INT,
-			UNSIGNED_INT,
-			BOOLEAN_,
-			CHARACTER,
-			VOID_POINTER,
-			BUFFER,
-			CUSTOM
-		};
+			snapshot.calls[i] = counters.calls[i].load(std::memory_order_relaxed);
+			snapshot.bytes[i] = counters.bytes[i].load(std::memory_order_relaxed);
+		}
+		snapshot.flushes = counters.flushes.load(std::memory_order_relaxed);
+		snapshot.truncations = counters.truncations.load(std::memory_order_relaxed);
+		snapshot.allocations = counters.allocations.load(std::memory_order_relaxed);
+		for(int i = 0; i < statistics::LATENCY_BUCKETS; ++i)
+			snapshot.latency[i] = counters.latency[i].load(std::memory_order_relaxed);
 
-		Parameter() : type (Type::NONE) {}
+		return snapshot;
+	}
 
-		~Parameter()
+	inline void reset_stats()
+	{
+		impl::stats_counters &counters = impl::global_stats();
+		for(int i = 0; i < statistics::TARGET_COUNT; ++i)
 		{
-			if(type == Type::CUSTOM)
-			{
-				typedef std::string sstring;
-				sstring *s = (sstring*)&object.raw;
-				s->~sstring();
-			}
+			counters.calls[i].store(0, std::memory_order_relaxed);
+			counters.bytes[i].store(0, std::memory_order_relaxed);
 		}
+		counters.flushes.store(0, std::memory_order_relaxed);
+		counters.truncations.store(0, std::memory_order_relaxed);
+		counters.allocations.store(0, std::memory_order_relaxed);
+		for(int i = 0; i < statistics::LATENCY_BUCKETS; ++i)
+			counters.latency[i].store(0, std::memory_order_relaxed);
+	}
+	#endif
 
-		void init(const double d, const signed char w = -1, const signed char p = -1)
-		{
-			width = w;
-			precision = p;
-			type = Type::FLOAT64;
-			object.f64 = d;
-		}
+	class Writer
+	{
+	public:
+		static constexpr int WRITER_BUFFER_SIZE = 1024;
 
-		void init(const signed long long i, const signed char w = -1, const signed char p = -1)
-		{
-			width = w;
-			precision = p;
-			type = Type::SIGNED_INT;
-			object.lli = i;
-		}
+		// hands each full buffer of output to a PrintTarget::SINK
+		typedef void (*sink_function)(void *sink, const char *data, size_t count);
 
-		void init(const unsigned long long i, const signed char w = -1, const signed char p = -1)
+		// for PrintTarget::STDSTRING, output is appended directly into the string's storage, user_buffer_size is
+		// then the initial amount of room to make for it
+		Writer(PrintTarget target, FILE *fp, int fd, std::string *stdstr, char *const user_buffer, const int user_buffer_size)
+			: Writer(target, fp, fd, stdstr, &resize_container<std::string>, NULL, stdstr == NULL ? 0 : stdstr->size(), user_buffer, user_buffer_size, true)
 		{
-			width = w;
-			precision = p;
-			type = Type::UNSIGNED_INT;
-			object.ulli = i;
 		}
 
-		void init(const bool b, const signed char w = -1, const signed char p = -1)
+		// PrintTarget::STDSTRING for any other contiguous container of char with resize(), like std::vector<char>
+		template <typename C> Writer(C &container, const int size_hint)
+			: Writer(PrintTarget::STDSTRING, NULL, -1, &container, &resize_container<C>, NULL, container.size(), NULL, size_hint, true)
 		{
-			width = w;
-			precision = p;
-			type = Type::BOOLEAN_;
-			object.b = b;
 		}
 
-		void init(const char c, const signed char w = -1, const signed char p = -1)
+		// PrintTarget::SINK, output is buffered and handed to write(sink, data, count) in pieces
+		Writer(void *sink, const sink_function write)
+			: Writer(PrintTarget::SINK, NULL, -1, sink, NULL, write, 0, NULL, 0, true)
 		{
-			width = w;
-			precision = p;
-			type = Type::CHARACTER;
-			object.c = c;
 		}
 
-		void init(const void *vp, const signed char w = -1, const signed char p = -1)
-		{
-			width = w;
-			precision = p;
-			type = Type::VOID_POINTER;
-			object.vp = vp;
-		}
+	private:
+		friend class Converter;
 
-		void init(const char *s, const signed char w = -1, const signed char p = -1)
+		typedef char *(*resize_function)(void *container, size_t size);
+
+		// scratch writers hold part of another Writer's output (an aligned field being measured), they aren't counted as
+		// calls in the PRESS_STATS counters
+		struct scratch {};
+
+		Writer(scratch, char *const field, const int size)
+			: Writer(PrintTarget::BUFFER, NULL, -1, NULL, NULL, NULL, 0, field, size, false)
 		{
-			width = w;
-			precision = p;
-			type = Type::BUFFER;
-			object.cstr = s;
 		}
 
-		void init(std::string &&str, const signed char w = -1, const signed char p = -1)
+		Writer(scratch, std::string &field, const int size_hint)
+			: Writer(PrintTarget::STDSTRING, NULL, -1, &field, &resize_container<std::string>, NULL, field.size(), NULL, size_hint, false)
 		{
-			width = w;
-			precision = p;
-			type = Type::CUSTOM;
-			new (&object.raw) std::string(std::move(str));
 		}
 
-		void convert(Writer &buffer, const Format &format) const
+		Writer(PrintTarget target, FILE *fp, int fd, void *container, const resize_function resize, const sink_function write, const size_t offset, char *const user_buffer, const int user_buffer_size, const bool counted);
+
+	public:
+		Writer(const Writer&) = delete;
+		Writer(Writer&&) = delete;
+		~Writer();
+
+		inline void write(const char *const buf, const int count)
 		{
-			switch(type)
+			const int written = std::min(m_size - m_bookmark, count);
+
+			memcpy(m_buffer + m_bookmark, buf, written);
+			m_bookmark += written;
+
+			if(written < count)
 			{
-				case Type::SIGNED_INT:
-					convert_int(buffer, format);
-					break;
-				case Type::UNSIGNED_INT:
-					convert_uint(buffer, format);
-					break;
-				case Type::BUFFER:
-					convert_string(buffer, format);
-					break;
-				case Type::CHARACTER:
-					convert_character(buffer, format);
-					break;
-				case Type::FLOAT64:
-					convert_float64(buffer, format);
-					break;
-				case Type::BOOLEAN_:
-					convert_bool(buffer, format);
-					break;
-				case Type::VOID_POINTER:
-					convert_voidp(buffer, format);
-					break;
-				case Type::CUSTOM:
-					convert_custom(buffer, format);
-					break;
-				default:
-					break;
+				if(flush())
+					write(buf + written, count - written);
+				else
+					m_dropped += count - written;
 			}
 		}
 
-	private:
-		static void reverse(char *buff, int len)
+		inline void fill(const char c, int count)
 		{
-			int index = 0;
-			int opposite = len - 1;
-			while(index < opposite)
+			for(;;)
 			{
-				char *a = buff + index;
-				char *b = buff + opposite;
+				const int filled = std::min(m_size - m_bookmark, count);
 
-				const char tmp = *a;
-				*a = *b;
-				*b = tmp;
+				memset(m_buffer + m_bookmark, c, filled);
+				m_bookmark += filled;
+				count -= filled;
 
-				++index;
-				--opposite;
+				if(count <= 0)
+					return;
+
+				if(!flush())
+				{
+					m_dropped += count;
+					return;
+				}
 			}
 		}
 
-		static inline bool is_positive(unsigned long long)
+		// same as write, but buf must stay valid until the Writer is destroyed (format string literals, string arguments). for
+		// PrintTarget::FD, long pieces are then passed to writev as they are instead of being copied into the buffer
+		inline void write_ref(const char *const buf, const int count)
 		{
-			return true;
+			// and long pieces go straight to a sink
+			if(m_target == PrintTarget::SINK && count >= SINK_THRESHOLD)
+			{
+				flush();
+				m_sink_write(m_container, buf, count);
+				m_flushed += count;
+				return;
+			}
+
+		#ifdef PRESS_HAS_FD
+			if(m_target == PrintTarget::FD && count >= IOV_THRESHOLD)
+			{
+				// room for the buffered piece, this piece, and the buffered piece that flush_fd queues after it
+				if(m_iov_count + 3 > IOV_COUNT)
+					flush();
+
+				queue_buffered();
+				m_iov[m_iov_count].iov_base = const_cast<char*>(buf);
+				m_iov[m_iov_count].iov_len = count;
+				++m_iov_count;
+				m_flushed += count;
+				return;
+			}
+		#endif
+
+			write(buf, count);
 		}
 
-		static inline bool is_positive(long long i)
+		// the number of bytes produced so far, including any that didn't fit in a user buffer
+		inline int total() const
 		{
-			return i >= 0;
+			return m_flushed + m_bookmark + m_dropped;
 		}
 
-		template <typename T> static int stringify_int(char *buffer, T i)
+	private:
+		static constexpr int MIN_STRING_GROWTH = 64;
+		static constexpr int SINK_THRESHOLD = 128;
+	#ifdef PRESS_HAS_FD
+		static constexpr int IOV_COUNT = 16;
+		static constexpr int IOV_THRESHOLD = 128;
+	#endif
+
+		bool flush();
+
+	#ifdef PRESS_HAS_FD
+		// close off the bytes buffered since the last queued piece as their own piece
+		inline void queue_buffered()
 		{
-			if(!std::is_integral<T>::value)
-				return 0;
-
-			bool negative = false;
-			if(std::is_signed<T>::value)
+			if(m_bookmark > m_iov_pending)
 			{
-				if(i == LLONG_MIN)
-				{
-					memcpy(buffer, "-9223372036854775808", 20);
-					return 20;
-				}
-				negative = !is_positive(i);
-				i = std::llabs(i);
+				m_iov[m_iov_count].iov_base = m_buffer + m_iov_pending;
+				m_iov[m_iov_count].iov_len = m_bookmark - m_iov_pending;
+				++m_iov_count;
+				m_iov_pending = m_bookmark;
 			}
+		}
 
-			int place = 0;
-			if(i == 0)
-				buffer[place++] = '0';
-			else
-			{
-				while(i)
-				{
-					buffer[place++] = (i % 10) + '0';
-					i /= 10;
-				}
-			}
-			if(negative)
-				buffer[place++] = '-';
+		void flush_fd();
+	#endif
 
-			reverse(buffer, place);
+		void grow(const int count);
 
-			return place;
+		template <typename C> static char *resize_container(void *container, const size_t size)
+		{
+			C &c = *(C*)container;
+			c.resize(size);
+			return &c[0];
 		}
 
-		static int stringify_int_hex(char *buffer, unsigned long long i, bool uppercase)
+		const PrintTarget m_target;
+		FILE *const m_fp; // optional file pointer
+		const int m_fd; // optional file descriptor
+		char *m_buffer; // interface to either m_automatic_buffer, user provided buffer, or the storage of m_container
+		void *m_container; // optional std::string (or other container) target, or the user's sink
+		resize_function m_resize; // for PrintTarget::STDSTRING
+		sink_function m_sink_write; // for PrintTarget::SINK
+		char m_automatic_buffer[WRITER_BUFFER_SIZE]; // used by print_target::FILEP
+		size_t m_string_offset; // where the output starts in m_container
+		int m_flushed; // bytes already handed off by flush()
+		int m_dropped; // bytes that didn't fit in the user buffer
+		int m_bookmark; // first unwritten byte
+		int m_size; // sizeof buffer pointed to by m_buffer
+	#ifdef PRESS_HAS_FD
+		struct iovec m_iov[IOV_COUNT]; // pieces waiting for writev, used by PrintTarget::FD
+		int m_iov_count;
+		int m_iov_pending; // start of the bytes in m_buffer not yet in m_iov
+	#endif
+	#ifdef PRESS_STATS
+		const bool m_counted; // false for scratch writers
+		const std::chrono::steady_clock::time_point m_start;
+	#endif
+	};
+
+	#ifdef PRESS_CORE_DEFINITIONS
+	PRESS_CORE Writer::Writer(PrintTarget target, FILE *fp, int fd, void *container, const resize_function resize, const sink_function write, const size_t offset, char *const user_buffer, const int user_buffer_size, const bool counted)
+		: m_target(target)
+		, m_fp(fp)
+		, m_fd(fd)
+		, m_buffer(user_buffer == NULL ? m_automatic_buffer : user_buffer)
+		, m_container(container)
+		, m_resize(resize)
+		, m_sink_write(write)
+		, m_string_offset(offset)
+		, m_flushed(0)
+		, m_dropped(0)
+		, m_bookmark(0)
+		, m_size(user_buffer == NULL ? WRITER_BUFFER_SIZE : user_buffer_size)
+	#ifdef PRESS_HAS_FD
+		, m_iov_count(0)
+		, m_iov_pending(0)
+	#endif
+	#ifdef PRESS_STATS
+		, m_counted(counted)
+		, m_start(std::chrono::steady_clock::now())
+	#endif
+	{
+	#ifdef PRESS_STATS
+		if(m_counted)
+			impl::count(impl::global_stats().calls[(int)m_target]);
+	#else
+		(void)counted;
+	#endif
+
+		if(m_target == PrintTarget::STDSTRING)
 		{
-			int place = 0;
-			const char base_character = uppercase ? 'A' : 'a';
+			m_size = 0;
+			grow(user_buffer_size > MIN_STRING_GROWTH ? user_buffer_size : MIN_STRING_GROWTH);
+		}
+	#ifndef PRESS_NO_FILE_LOCK
+		else if(m_target == PrintTarget::FILE_P)
+			PRESS_LOCK_FILE(m_fp);
+	#endif
+	}
 
-			if(i == 0)
-				buffer[place++] = '0';
-			else
-			{
-				while(i)
-				{
-					const char h = (i % 16);
-					if(h < 10)
-						buffer[place++] = h + '0';
-					else
-						buffer[place++] = (h - 10) + base_character;
-					i /= 16;
-				}
-			}
+	PRESS_CORE Writer::~Writer()
+	{
+		if(m_target == PrintTarget::BUFFER && m_size > 0)
+			m_buffer[m_bookmark >= m_size ? m_size - 1 : m_bookmark] = 0;
+		else if(m_target == PrintTarget::STDSTRING)
+			m_resize(m_container, m_string_offset + m_bookmark);
+		else
+			flush();
+
+	#ifndef PRESS_NO_FILE_LOCK
+		if(m_target == PrintTarget::FILE_P)
+			PRESS_UNLOCK_FILE(m_fp);
+	#endif
+
+	#ifdef PRESS_STATS
+		if(!m_counted)
+			return;
+
+		impl::stats_counters &counters = impl::global_stats();
+		impl::count(counters.bytes[(int)m_target], total());
+		if(m_dropped > 0)
+			impl::count(counters.truncations);
+		impl::count_latency(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+	#endif
+	}
 
-			reverse(buffer, place);
-			return place;
+	PRESS_CORE bool Writer::flush()
+	{
+		if(m_target == PrintTarget::BUFFER)
+			return false;
+		else if(m_target == PrintTarget::STDSTRING)
+		{
+			// keep the bookmark, just make more room
+			grow(m_size);
+			return true;
+		}
+		else if(m_target == PrintTarget::FILE_P)
+		{
+			PRESS_FWRITE(m_buffer, m_bookmark, m_fp);
+		#ifdef PRESS_STATS
+			if(m_bookmark > 0)
+				impl::count(impl::global_stats().flushes);
+		#endif
+		}
+		else if(m_target == PrintTarget::SINK)
+		{
+			if(m_bookmark > 0)
+				m_sink_write(m_container, m_buffer, m_bookmark);
 		}
+	#ifdef PRESS_HAS_FD
+		else if(m_target == PrintTarget::FD)
+			flush_fd();
+	#endif
+
+		m_flushed += m_bookmark;
+		m_bookmark = 0;
+		return true;
+	}
 
-		static int stringify_int_oct(char *buffer, unsigned long long i)
+	#ifdef PRESS_HAS_FD
+	PRESS_CORE void Writer::flush_fd()
+	{
+		queue_buffered();
+	#ifdef PRESS_STATS
+		if(m_iov_count > 0)
+			impl::count(impl::global_stats().flushes);
+	#endif
+
+		struct iovec *iov = m_iov;
+		int remaining = m_iov_count;
+		while(remaining > 0)
 		{
-			int place = 0;
-			if(i == 0)
-				buffer[place++] = '0';
-			else
+			const ssize_t written = remaining == 1 ? ::write(m_fd, iov->iov_base, iov->iov_len) : ::writev(m_fd, iov, remaining);
+			if(written < 0)
 			{
-				while(i)
-				{
-					buffer[place++] = (i % 8) + 48;
-					i /= 8;
-				}
+				if(errno == EINTR)
+					continue;
+
+				// like a failed fwrite, the output is lost
+				break;
 			}
 
-			reverse(buffer, place);
-			return place;
+			// skip whatever was taken by a partial write
+			size_t skip = written;
+			while(remaining > 0 && skip >= iov->iov_len)
+			{
+				skip -= iov->iov_len;
+				++iov;
+				--remaining;
+			}
+			if(remaining > 0)
+			{
+				iov->iov_base = (char*)iov->iov_base + skip;
+				iov->iov_len -= skip;
+			}
+		}
+
+		m_iov_count = 0;
+		m_iov_pending = 0;
+	}
+	#endif
+
+	PRESS_CORE void Writer::grow(const int count)
+	{
+		m_size += count;
+		m_buffer = m_resize(m_container, m_string_offset + m_size) + m_string_offset;
+	}
+	#endif
+
+	// type specific conversions, shared by the type-erased Parameter path and the static dispatch path
+	class Converter
+	{
+	public:
+		// any integer type, widened to long long or unsigned long long by its signedness
+		template <typename T> static void integer(Writer &buffer, const T number, const Format &format, int runtime_width)
+		{
+			static_assert(std::is_integral<T>::value, "press: Converter::integer takes an integer");
+			typedef typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type wide;
+			wide_integer<wide>(buffer, (wide)number, format, runtime_width);
 		}
 
-		template <typename T> static void do_convert_integer(const T number, Writer &buffer, const Format &format, int runtime_width)
+		template <typename T> static void wide_integer(Writer &buffer, const T number, const Format &format, int runtime_width)
 		{
 			char string[22]; // big enough to store largest number in base 8, 10, and 16 (no terminating char needed)
 
@@ -552,20 +1013,27 @@ namespace press
 			else
 				written = stringify_int(string, number);
 
-			// calculate width
-			int width = runtime_width == -1 ? (format.width >= 0 ? format.width - (format.leading_space && is_positive(number)) : 0) : runtime_width;
-
-			// calculate how many thousands separaters are needed
-			int seps = 0;
-			if(format.thousands_sep != 0)
+			// group the digits in a second buffer so they go out in a single write
+			char grouped[128];
+			const char *digits = string;
+			if(format.group_thousands)
 			{
-				seps = (written % 3) == 0 ? (written / 3) - 1 : (written / 3);
-				width -= seps;
+				written = group(grouped + sizeof(grouped), string, written, !is_positive(number), get_locale());
+				digits = grouped + sizeof(grouped) - written;
 			}
 
+			// the prefix of the alternate form, which goes before any zero padding. like printf, 0 has none
+			const char *const prefix = format.hex_upper ? "0X" : (format.hex ? "0x" : "0");
+			const int prefix_length = !format.alternate || !std::is_unsigned<T>::value || number == 0 ? 0 : ((format.hex || format.hex_upper) ? 2 : (format.oct ? 1 : 0));
+
+			// calculate width
+			const int width = runtime_width == -1 ? (format.width >= 0 ? format.width - (format.leading_space && is_positive(number)) : 0) : runtime_width;
+
 			// more padding calculations
-			int needed = std::max(width, written); // how many chars will actually be written
-			const char pad = format.zero_pad ? '0' : ' ';
+			const int length = written + prefix_length;
+			const int needed = std::max(width, length); // how many chars will actually be written
+			const char pad = format.zero_pad ? '0' : format.fill;
+			const int before = format.left_justify ? 0 : (format.align == '^' ? (needed - length) / 2 : needed - length);
 
 			// write a leading space if requested
 			if(format.leading_space && is_positive(number))
@@ -575,396 +1043,3904 @@ namespace press
 			const bool negative_and_zero_pad = !is_positive(number) && format.zero_pad;
 			if(negative_and_zero_pad)
 				buffer.write(string, 1);
+			if(prefix_length > 0 && format.zero_pad)
+				buffer.write(prefix, prefix_length);
 
 			// apply leading pad chars
-			if(!format.left_justify)
-				for(int i = needed; i > written; --i)
-					buffer.write(&pad, 1);
+			if(before > 0)
+				buffer.fill(pad, before);
+
+			if(prefix_length > 0 && !format.zero_pad)
+				buffer.write(prefix, prefix_length);
 
 			// write the integer string
-			if(seps == 0)
-				buffer.write(string + (int)negative_and_zero_pad, written - (int)negative_and_zero_pad);
-			else
+			buffer.write(digits + (int)negative_and_zero_pad, written - (int)negative_and_zero_pad);
+
+			// apply trailing pad chars
+			if(needed - length > before)
+				buffer.fill(pad, needed - length - before);
+		}
+
+		static void float64(Writer &buffer, const double number, const Format &format, int runtime_width, int runtime_precision);
+
+		// in hex, with the same flags as an unsigned integer
+		static void pointer(Writer &buffer, const void *vp, const Format &format, int runtime_width)
+		{
+			Format spec = format;
+			spec.hex = !format.hex_upper;
+			spec.oct = false;
+			spec.group_thousands = false;
+			integer<unsigned long long>(buffer, reinterpret_cast<uintptr_t>(vp), spec, runtime_width);
+		}
+
+		// the bytes of a buffer in hex, optionally with a separator between bytes. the precision limits the number of bytes
+		static void bytes(Writer &buffer, const unsigned char *data, size_t length, const char separator, const Format &format, int runtime_width, int runtime_precision)
+		{
+			const int precision = runtime_precision == -1 ? format.precision : runtime_precision;
+			if(precision >= 0 && (size_t)precision < length)
+				length = precision;
+
+			const size_t total = length * 2 + (separator != 0 && length > 0 ? length - 1 : 0);
+			const int after = pad_before(buffer, total > INT_MAX ? INT_MAX : (int)total, format, runtime_width);
+
+			// convert a block at a time
+			static constexpr size_t BLOCK = 256;
+			char out[BLOCK * 3];
+			for(size_t done = 0; done < length; done += BLOCK)
 			{
-				int place = written % 3;
-				if(place != 0)
+				const size_t count = std::min(BLOCK, length - done);
+				if(separator == 0)
 				{
-					buffer.write(string, place);
-					buffer.write(&format.thousands_sep, 1);
+					hex_bytes(out, data + done, count, format.hex_upper);
+					buffer.write(out, count * 2);
 				}
-				for(; place < written; place += 3)
+				else
 				{
-					buffer.write(string + place, 3);
-					if(place < written - 3)
-						buffer.write(&format.thousands_sep, 1);
+					const char *const nibbles = format.hex_upper ? "0123456789ABCDEF" : "0123456789abcdef";
+					char *o = out;
+					if(done > 0)
+						*o++ = separator;
+					for(size_t i = 0; i < count; ++i)
+					{
+						if(i > 0)
+							*o++ = separator;
+						*o++ = nibbles[data[done + i] >> 4];
+						*o++ = nibbles[data[done + i] & 0xf];
+					}
+					buffer.write(out, o - out);
 				}
 			}
 
-			// apply trailing pad chars
-			if(format.left_justify)
-				for(int i = needed; i > written; --i)
-					buffer.write(&pad, 1);
+			if(after > 0)
+				buffer.fill(format.fill, after);
 		}
 
-		void convert_float64(Writer &buffer, const Format &format) const
+		static void string(Writer &buffer, const char *cstr, const Format &format, int runtime_width, int runtime_precision)
 		{
-			char buf[325];
-			const int written = snprintf(buf, sizeof(buf), "%.*f", precision == -1 ? (format.precision >= 0 ? format.precision : 6) : precision, object.f64);
-			const int min = std::min(324, written);
-			buffer.write(buf, min);
+			// with a precision, don't scan any further than what will be printed
+			const int precision = runtime_precision == -1 ? format.precision : runtime_precision;
+			const char *const end = precision < 0 ? NULL : (const char*)memchr(cstr, 0, precision);
+			const size_t strlength = precision < 0 ? strlen(cstr) : (end == NULL ? precision : end - cstr);
+			text(buffer, cstr, strlength, format, runtime_width, true);
 		}
 
-		void convert_uint(Writer &buffer, const Format &format) const
+		static void string(Writer &buffer, const str_ref &str, const Format &format, int runtime_width, int runtime_precision)
 		{
-			Parameter::do_convert_integer<unsigned long long>(object.ulli, buffer, format, (int)width);
+			const int precision = runtime_precision == -1 ? format.precision : runtime_precision;
+			const size_t len = precision < 0 ? str.length : std::min((size_t)precision, str.length);
+			text(buffer, str.data, len, format, runtime_width, true);
 		}
 
-		void convert_int(Writer &buffer, const Format &format) const
+		static void boolean(Writer &buffer, const bool b, const Format &format, int runtime_width)
 		{
-			Parameter::do_convert_integer<long long>(object.lli, buffer, format, (int)width);
+			text(buffer, b ? "true" : "false", b ? 4 : 5, format, runtime_width);
 		}
 
-		void convert_voidp(Writer &buffer, const Format&) const
+		static void character(Writer &buffer, const char c, const Format &format, int runtime_width)
 		{
-			char buf[16];
-			unsigned long long number = reinterpret_cast<uintptr_t>(object.vp);
-			const int written = Parameter::stringify_int_hex(buf, number, false);
-
-			buffer.write(buf, written);
+			text(buffer, &c, 1, format, runtime_width);
 		}
 
-		void convert_string(Writer &buffer, const Format &format) const
+		static void custom(Writer &buffer, const std::string &s, const Format &format, int runtime_width)
 		{
-			const auto strlength = strlen(object.cstr);
-			const int len = std::min(precision == -1 ? (format.precision < 0 ? strlength : format.precision) : precision, strlength);
-			buffer.write(object.cstr, len);
+			text(buffer, s.c_str(), s.length(), format, runtime_width);
 		}
 
-		void convert_bool(Writer &buffer, const Format&) const
+		// user provided format_to, runtime width and precision are folded into the spec it receives. with an explicit
+		// alignment the whole field is padded here instead, whatever the formatter does with the width
+		static void formatter(Writer &buffer, void (*fn)(Writer&, const void*, const Format&), const void *object, const Format &format, int runtime_width, int runtime_precision)
 		{
-			buffer.write(object.b ? "true" : "false", object.b ? 4 : 5);
-		}
+			const int width = runtime_width == -1 ? format.width : runtime_width;
+			if(format.align != 0 && width > 0)
+			{
+				Format spec = format;
+				spec.width = -1;
+				spec.align = 0;
+				spec.left_justify = false;
+				spec.fill = ' ';
+				if(runtime_precision != -1)
+					spec.precision = runtime_precision;
+				aligned(buffer, fn, object, spec, format, width);
+				return;
+			}
 
-		void convert_character(Writer &buffer, const Format&) const
-		{
-			char c = object.c;
-			buffer.write(&c, 1);
-		}
+			if(runtime_width == -1 && runtime_precision == -1)
+			{
+				fn(buffer, object, format);
+				return;
+			}
 
-		void convert_custom(Writer &buffer, const Format&) const
-		{
-			const std::string *s = (const std::string*)&object.raw;
-			buffer.write(s->c_str(), s->length());
+			Format spec = format;
+			if(runtime_width != -1)
+				spec.width = runtime_width;
+			if(runtime_precision != -1)
+				spec.precision = runtime_precision;
+			fn(buffer, object, spec);
 		}
 
-		Type type;
-		union
+		// writes the padding that goes before a field of the given length, returns how much padding goes after it
+		static int pad_before(Writer &buffer, const int length, const Format &format, int runtime_width, const char pad)
 		{
-			long long lli;
-			unsigned long long ulli;
-			double f64;
-			char c;
-			const void *vp;
-			bool b;
-			const char *cstr;
-			std::aligned_storage<sizeof(std::string), alignof(std::string)>::type raw;
-		} object;
-		signed char width;
-		signed char precision;
-	};
-
-	constexpr bool is_literal_brace(const char *fmt, int len, int index)
-	{
-		return
-		(index > len - 3) ?
-			(false)
-			: (fmt[index] == '{' && fmt[index + 1] == '{' && fmt[index + 2] == '}');
-	}
-
-	constexpr bool is_balanced(const char *fmt, int len, int index = 0, int open = 0)
-	{
-		return
-			(index >= len) ?
-				(open == 0)
-				: ((fmt[index] == '{') ?
-					(is_literal_brace(fmt, len, index) ?
-						(is_balanced(fmt, len, index + 3, open))
-						: (is_balanced(fmt, len, index + 1, open + 1)))
-					: ((fmt[index] == '}') ?
-						((open > 0) ?
-							(is_balanced(fmt, len, index + 1, open - 1))
-							: (is_balanced(fmt, len, index + 1, open)))
-						: (is_balanced(fmt, len, index + 1, open))));
-	}
+			const int width = runtime_width == -1 ? format.width : runtime_width;
+			if(width <= length)
+				return 0;
 
-	constexpr int find_partner(const char *fmt, int len, int index)
-	{
-		return
-		(index >= len) ?
-			(-1)
-			: ((fmt[index] == '}') ?
-				(index)
-				: (find_partner(fmt, len, index + 1)));
-	}
+			const int padding = width - length;
+			const int before = format.left_justify ? 0 : (format.align == '^' ? padding / 2 : padding);
+			if(before > 0)
+				buffer.fill(pad, before);
 
-	constexpr int count_specifiers(const char *fmt, int len, int count = 0, int index = 0)
-	{
-		return
-		(index >= len) ?
-			(count)
-			: ((fmt[index] != '{') ?
-				(count_specifiers(fmt, len, count, index + 1))
-				: ((is_literal_brace(fmt, len, index)) ?
-					(count_specifiers(fmt, len, count, index + 3))
-					: ((find_partner(fmt, len, index + 1) == -1) ?
-						(count)
-						: (count_specifiers(fmt, len, count + 1, find_partner(fmt, len, index + 1) + 1)))));
-	}
+			return padding - before;
+		}
 
-	template <typename T> std::string to_string(const T&)
-	{
-		return "{UNKNOWN DATA TYPE}";
-	}
+		static int pad_before(Writer &buffer, const int length, const Format &format, int runtime_width)
+		{
+			return pad_before(buffer, length, format, runtime_width, format.fill);
+		}
 
-	namespace impl{
-	static void printer(const char *const fmt, const Parameter *const params, const int pack_size, const PrintTarget target, FILE *fp, std::string *stdstring, char *userbuffer, const int userbuffer_size)
-	{
-		const int fmt_len = strlen(fmt);
-		const int spec_count = count_specifiers(fmt, fmt_len);
+		// stable: s outlives the Writer (see Writer::write_ref)
+		static void text(Writer &buffer, const char *s, const int length, const Format &format, int runtime_width, bool stable = false)
+		{
+			const int after = pad_before(buffer, length, format, runtime_width);
+			if(stable)
+				buffer.write_ref(s, length);
+			else
+				buffer.write(s, length);
+			if(after > 0)
+				buffer.fill(format.fill, after);
+		}
 
-		// buffering
-		Writer output(target, fp, stdstring, userbuffer, userbuffer_size);
+	private:
+		friend class FloatConverter;
 
-		// begin printing
-		int bookmark = 0;
-		for(int k = 0; k < spec_count; ++k)
+		// formats the field into a side buffer to measure it, then pads it. fields too long for the buffer are formatted again
+		// into a string
+		static void aligned(Writer &buffer, void (*fn)(Writer&, const void*, const Format&), const void *object, const Format &spec, const Format &format, const int width)
 		{
-			// find the first open specifier bracket and extract the spec
-			int spec_begin = bookmark;
-			for(; spec_begin < fmt_len; ++spec_begin)
+			char field[256];
+			int length;
 			{
-				const char c = fmt[spec_begin];
-
-				if(c == '{')
-				{
-					break;
-				}
+				Writer side(Writer::scratch(), field, sizeof(field));
+				fn(side, object, spec);
+				length = side.total();
 			}
 
-			if(spec_begin >= fmt_len)
+			// the buffer target keeps its last byte for the terminator
+			if(length < (int)sizeof(field))
+			{
+				text(buffer, field, length, format, width);
 				return;
+			}
 
-			// print the "before" text
-			output.write(fmt + bookmark, spec_begin - bookmark);
-			if(is_literal_brace(fmt, fmt_len, spec_begin))
+			std::string long_field;
 			{
-				output.write("{", 1);
-				bookmark = spec_begin + 3;
-				--k;
-				continue;
+				Writer side(Writer::scratch(), long_field, length);
+				fn(side, object, spec);
 			}
-
-			Format format_settings;
-			bookmark = Format::parse(fmt, spec_begin + 1, fmt_len, format_settings) + 1;
-
-			const bool spec_index_overridden = format_settings.index >= 0;
-			const int index = spec_index_overridden ? format_settings.index - 1 : k;
-			if(spec_index_overridden && (index < 0 || index >= (int)pack_size))
-				output.write("{UNDEFINED}", 11);
-			else if(!spec_index_overridden && index >= (int)pack_size)
-				output.write("{UNDEFINED}", 11);
-			else
-				params[index].convert(output, format_settings);
+			text(buffer, long_field.data(), long_field.size(), format, width);
 		}
 
-		// print the "tail"
-		if(bookmark < fmt_len)
+		// write the digits in string, separated into groups by the locale, backwards from end. returns the length written
+		static int group(char *const end, const char *const string, const int length, const bool sign, const locale_info &locale)
 		{
-			// look for literal brace patterns
-			for(;;)
+			char *out = end;
+			int source = length;
+			int size_index = 0;
+			int group_size = locale.grouping[0];
+			int in_group = 0;
+
+			while(source > (int)sign)
 			{
-				int index = bookmark;
-				bool found = false;
-				while(index < fmt_len)
+				if(group_size > 0 && group_size != CHAR_MAX && in_group == group_size)
 				{
-					if(is_literal_brace(fmt, fmt_len, index))
-					{
-						found = true;
-						break;
-					}
+					out -= locale.thousands_sep_length;
+					memcpy(out, locale.thousands_sep, locale.thousands_sep_length);
+					in_group = 0;
 
-					++index;
+					// the last group size repeats
+					if(locale.grouping[size_index + 1] != 0)
+						group_size = locale.grouping[++size_index];
 				}
 
-				if(!found)
-					break;
-
-				// print the text before the brace pattern
-				output.write(fmt + bookmark, index - bookmark);
-
-				// print a literal brace
-				const char brace = '{';
-				output.write(&brace, 1);
-
-				bookmark = index + 3;
+				*--out = string[--source];
+				++in_group;
 			}
 
-			// write the last little bit
-			output.write(fmt + bookmark, fmt_len - bookmark);
+			if(sign)
+				*--out = string[0];
+
+			return end - out;
 		}
-	};
 
-	template <typename T> struct is_pointer
-	{
-		constexpr static bool value = std::is_pointer<T>::value || std::is_member_pointer<T>::value || std::is_member_object_pointer<T>::value || std::is_member_function_pointer<T>::value || std::is_function<typename std::remove_pointer<T>::type>::value;
-	};
+		static inline bool is_positive(unsigned long long)
+		{
+			return true;
+		}
 
-	// dummy primary template
-	template <typename T> inline void add_ptr(const typename std::enable_if<!is_pointer<T>::value, T>::type&, Parameter*, int&, signed char, signed char) {}
+		static inline bool is_positive(long long i)
+		{
+			return i >= 0;
+		}
 
-	// catch pointers
-	template <typename T> inline void add_ptr(const typename std::enable_if<is_pointer<T>::value, T>::type& vp, Parameter *array, int &index, signed char w = -1, signed char p = -1)
-	{
-		array[index++].init((void*)vp, w, p);
-	}
+		// number of significant bits in i, treating 0 as 1 bit wide
+		static inline int bit_width(const unsigned long long i)
+		{
+		#if defined (__GNUC__)
+			return 64 - __builtin_clzll(i | 1);
+		#else
+			int width = 1;
+			while(width < 64 && (i >> width) != 0)
+				++width;
+			return width;
+		#endif
+		}
 
-	template <typename T> inline void add(const T &x, Parameter *array, int &index, signed char w = -1, signed char p = -1)
-	{
-		if(is_pointer<T>::value)
+		static inline int count_digits(const unsigned long long i)
 		{
-			add_ptr<T>(x, array, index, w, p);
+			static const unsigned long long powers_of_10[] =
+			{
+				0ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+				10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+				1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+				10000000000000000000ull
+			};
+
+			// approximate log10 from log2 (1233 / 4096 ~= log10(2)), then correct using the table
+			const int t = (bit_width(i) * 1233) >> 12;
+			return t - (i < powers_of_10[t]) + 1;
 		}
-		else
+
+		// writes the decimal digits of i right-to-left, ending just before end
+		static inline void write_decimal(char *end, unsigned long long i)
 		{
-			array[index++].init(std::move(press::to_string(x)));
+			static const char digit_pairs[] =
+				"0001020304050607080910111213141516171819"
+				"2021222324252627282930313233343536373839"
+				"4041424344454647484950515253545556575859"
+				"6061626364656667686970717273747576777879"
+				"8081828384858687888990919293949596979899";
+
+			while(i >= 100)
+			{
+				const unsigned pair = (unsigned)(i % 100) * 2;
+				i /= 100;
+				end -= 2;
+				memcpy(end, digit_pairs + pair, 2);
+			}
+
+			if(i >= 10)
+				memcpy(end - 2, digit_pairs + i * 2, 2);
+			else
+				*(end - 1) = (char)('0' + i);
 		}
-	}
 
-	// add the argument to the parameter array
-	inline void add(const unsigned long long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
+		template <typename T> static int stringify_int(char *buffer, T i)
+		{
+			if(!std::is_integral<T>::value)
+				return 0;
+
+			// negate as unsigned so that LLONG_MIN needs no special case
+			const bool negative = !is_positive(i);
+			const unsigned long long magnitude = negative ? 0ull - (unsigned long long)i : (unsigned long long)i;
+
+			const int digits = count_digits(magnitude);
+			if(negative)
+				buffer[0] = '-';
+
+			const int place = digits + negative;
+			write_decimal(buffer + place, magnitude);
+
+			return place;
+		}
+
+		// buffer must have room for 16 digits, whatever the value
+		static int stringify_int_hex(char *buffer, unsigned long long i, bool uppercase)
+		{
+			const int place = (bit_width(i) + 3) / 4;
+
+			// shift the significant digits to the top, then convert all 16 digits of the big endian bytes at once
+			const unsigned long long top = i << (64 - 4 * place);
+		#if defined (__GNUC__) && defined (__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			const unsigned long long big_endian = __builtin_bswap64(top);
+			unsigned char bytes[8];
+			memcpy(bytes, &big_endian, 8);
+		#else
+			unsigned char bytes[8];
+			for(int k = 0; k < 8; ++k)
+				bytes[k] = (unsigned char)(top >> (56 - 8 * k));
+		#endif
+
+			hex_bytes(buffer, bytes, 8, uppercase);
+			return place;
+		}
+
+		// writes 2 hex digits for each byte, 8 or 16 bytes per step with SIMD
+		static void hex_bytes(char *out, const unsigned char *data, size_t count, const bool uppercase)
+		{
+		#if defined (PRESS_SIMD_SSE2)
+			const __m128i low_mask = _mm_set1_epi8(0x0f);
+			const __m128i nine = _mm_set1_epi8(9);
+			const __m128i zero = _mm_set1_epi8('0');
+			const __m128i letters = _mm_set1_epi8((uppercase ? 'A' : 'a') - '0' - 10);
+			for(; count >= 8; count -= 8, data += 8, out += 16)
+			{
+				const __m128i v = _mm_loadl_epi64((const __m128i*)data);
+				const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), low_mask);
+				const __m128i nibbles = _mm_unpacklo_epi8(high, _mm_and_si128(v, low_mask));
+				const __m128i digits = _mm_add_epi8(_mm_add_epi8(nibbles, zero), _mm_and_si128(_mm_cmpgt_epi8(nibbles, nine), letters));
+				_mm_storeu_si128((__m128i*)out, digits);
+			}
+		#elif defined (PRESS_SIMD_NEON)
+			const uint8x16_t nine = vdupq_n_u8(9);
+			const uint8x16_t zero = vdupq_n_u8('0');
+			const uint8x16_t letters = vdupq_n_u8((uppercase ? 'A' : 'a') - '0' - 10);
+			for(; count >= 8; count -= 8, data += 8, out += 16)
+			{
+				const uint8x8_t v = vld1_u8(data);
+				const uint8x8x2_t pairs = vzip_u8(vshr_n_u8(v, 4), vand_u8(v, vdup_n_u8(0x0f)));
+				const uint8x16_t nibbles = vcombine_u8(pairs.val[0], pairs.val[1]);
+				vst1q_u8((uint8_t*)out, vaddq_u8(vaddq_u8(nibbles, zero), vandq_u8(vcgtq_u8(nibbles, nine), letters)));
+			}
+		#endif
+
+			const char *const nibbles = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+			for(size_t i = 0; i < count; ++i)
+			{
+				out[i * 2] = nibbles[data[i] >> 4];
+				out[i * 2 + 1] = nibbles[data[i] & 0xf];
+			}
+		}
+
+		static int stringify_int_oct(char *buffer, unsigned long long i)
+		{
+			const int place = (bit_width(i) + 2) / 3;
+
+			for(int index = place - 1; index >= 0; --index)
+			{
+				buffer[index] = (char)('0' + (i & 7));
+				i >>= 3;
+			}
+
+			return place;
+		}
+	};
+
+	// native floating point conversion: exact fixed and scientific notation (producing the same digits as printf's
+	// %f and %e), and shortest round-trip digits using Grisu2
+	class FloatConverter
+	{
+	public:
+		static void fixed(Writer &buffer, const double number, int precision, const Format &format, const int runtime_width, const char point)
+		{
+			if(!is_finite(buffer, number, format, runtime_width))
+				return;
+
+			if(precision > MAX_PRECISION)
+				precision = MAX_PRECISION;
+			Expansion x(number);
+
+			// fraction digits first, rounding may carry into the integer part
+			char frac[MAX_PRECISION];
+			for(int i = 0; i < precision; ++i)
+				frac[i] = '0' + x.next_fraction_digit();
+
+			const int half = x.compare_half();
+			const bool odd = precision > 0 ? ((frac[precision - 1] - '0') & 1) : x.integer_is_odd();
+			if(half > 0 || (half == 0 && odd))
+			{
+				int i = precision - 1;
+				while(i >= 0 && frac[i] == '9')
+					frac[i--] = '0';
+
+				if(i >= 0)
+					++frac[i];
+				else
+					x.increment_integer();
+			}
+
+			const int length = x.negative + x.integer_length() + (precision > 0 ? precision + 1 : 0);
+			const int after = begin_field(buffer, x.negative, length, format, runtime_width);
+			x.write_integer(buffer);
+			if(precision > 0)
+			{
+				buffer.write(&point, 1);
+				buffer.write(frac, precision);
+			}
+			if(after > 0)
+				buffer.fill(format.fill, after);
+		}
+
+		// precision < 0 selects the shortest representation
+		static void scientific(Writer &buffer, const double number, int precision, const Format &format, const int runtime_width, const char point)
+		{
+			if(!is_finite(buffer, number, format, runtime_width))
+				return;
+
+			char digits[MAX_PRECISION + 1];
+			int length;
+			int exponent;
+
+			if(precision < 0)
+			{
+				int K;
+				shortest(number, digits, length, K);
+				exponent = length + K - 1;
+			}
+			else
+			{
+				if(precision > MAX_PRECISION - 1)
+					precision = MAX_PRECISION - 1;
+				length = precision + 1;
+				exponent = 0;
+
+				Expansion x(number);
+				x.prepare_integer();
+
+				int count = 0;
+				if(number != 0.0)
+				{
+					// find the first significant digit
+					int d = x.next_digit();
+					if(x.integer_digits > 0)
+						exponent = x.integer_digits - 1;
+					else
+					{
+						exponent = -1;
+						while(d == 0)
+						{
+							d = x.next_digit();
+							--exponent;
+						}
+					}
+
+					digits[count++] = '0' + d;
+				}
+
+				while(count < length)
+					digits[count++] = '0' + x.next_digit();
+
+				const int half = x.compare_rest_half();
+				if(half > 0 || (half == 0 && ((digits[length - 1] - '0') & 1)))
+				{
+					int i = length - 1;
+					while(i >= 0 && digits[i] == '9')
+						digits[i--] = '0';
+
+					if(i >= 0)
+						++digits[i];
+					else
+					{
+						digits[0] = '1';
+						++exponent;
+					}
+				}
+			}
+
+			const bool negative = signbit(number);
+			if(precision < 0)
+				precision = length - 1;
+
+			const int after = begin_field(buffer, negative, negative + scientific_length(precision, exponent), format, runtime_width);
+			write_scientific(buffer, digits, length, precision, exponent, point);
+			if(after > 0)
+				buffer.fill(format.fill, after);
+		}
+
+		// shortest round-trip digits, in fixed notation for moderate exponents and scientific notation otherwise
+		static void general(Writer &buffer, const double number, const Format &format, const int runtime_width, const char point)
+		{
+			if(!is_finite(buffer, number, format, runtime_width))
+				return;
+
+			char digits[MAX_PRECISION + 1];
+			int length;
+			int K;
+			shortest(number, digits, length, K);
+
+			const bool negative = signbit(number);
+			const int exponent = length + K - 1;
+			const int decimal_point = length + K; // digits before the decimal point
+			const bool use_scientific = exponent < -4 || exponent >= 16;
+
+			int field = negative;
+			if(use_scientific)
+				field += scientific_length(length - 1, exponent);
+			else if(K >= 0)
+				field += length + K;
+			else if(decimal_point > 0)
+				field += length + 1;
+			else
+				field += 2 - decimal_point + length;
+
+			const int after = begin_field(buffer, negative, field, format, runtime_width);
+			if(use_scientific)
+				write_scientific(buffer, digits, length, length - 1, exponent, point);
+			else if(K >= 0)
+			{
+				buffer.write(digits, length);
+				write_zeros(buffer, K);
+			}
+			else if(decimal_point > 0)
+			{
+				buffer.write(digits, decimal_point);
+				buffer.write(&point, 1);
+				buffer.write(digits + decimal_point, length - decimal_point);
+			}
+			else
+			{
+				buffer.write("0", 1);
+				buffer.write(&point, 1);
+				write_zeros(buffer, -decimal_point);
+				buffer.write(digits, length);
+			}
+
+			if(after > 0)
+				buffer.fill(format.fill, after);
+		}
+
+	private:
+		static constexpr int MAX_PRECISION = 128;
+
+		static inline bool signbit(const double number)
+		{
+			uint64_t bits;
+			memcpy(&bits, &number, sizeof(bits));
+			return (bits >> 63) != 0;
+		}
+
+		// writes nan and inf the way printf does
+		static bool is_finite(Writer &buffer, const double number, const Format &format, const int runtime_width)
+		{
+			if(number - number == number - number)
+				return true;
+
+			const bool negative = signbit(number);
+			if(number != number)
+				Converter::text(buffer, negative ? "-nan" : "nan", negative ? 4 : 3, format, runtime_width);
+			else
+				Converter::text(buffer, negative ? "-inf" : "inf", negative ? 4 : 3, format, runtime_width);
+
+			return false;
+		}
+
+		// writes the sign and the padding that goes before it, returns how much padding goes after the field
+		static int begin_field(Writer &buffer, const bool negative, const int length, const Format &format, const int runtime_width)
+		{
+			if(format.zero_pad)
+			{
+				if(negative)
+					buffer.write("-", 1);
+				return Converter::pad_before(buffer, length, format, runtime_width, '0');
+			}
+
+			const int after = Converter::pad_before(buffer, length, format, runtime_width);
+			if(negative)
+				buffer.write("-", 1);
+			return after;
+		}
+
+		static int scientific_length(const int precision, const int exponent)
+		{
+			return 1 + (precision > 0 ? precision + 1 : 0) + (exponent <= -100 || exponent >= 100 ? 5 : 4);
+		}
+
+		static void write_zeros(Writer &buffer, int count)
+		{
+			if(count > 0)
+				buffer.fill('0', count);
+		}
+
+		static void write_scientific(Writer &buffer, const char *digits, const int length, const int precision, const int exponent, const char point)
+		{
+			buffer.write(digits, 1);
+			if(precision > 0)
+			{
+				buffer.write(&point, 1);
+				buffer.write(digits + 1, length - 1);
+				write_zeros(buffer, precision - (length - 1));
+			}
+
+			char exp[6];
+			int place = 0;
+			exp[place++] = 'e';
+			exp[place++] = exponent < 0 ? '-' : '+';
+			const unsigned magnitude = exponent < 0 ? -exponent : exponent;
+			if(magnitude >= 100)
+				exp[place++] = '0' + magnitude / 100;
+			exp[place++] = '0' + (magnitude / 10) % 10;
+			exp[place++] = '0' + magnitude % 10;
+			buffer.write(exp, place);
+		}
+
+		// little-endian arbitrary precision unsigned integer, big enough for any double's integer part or for its
+		// fraction scaled by 2^1074 (plus a few bits of headroom for digit generation)
+		struct Bignum
+		{
+			static constexpr int MAX_LIMBS = 36;
+
+			void assign_shifted(const uint64_t value, const int shift)
+			{
+				const int word = shift / 32;
+				const int bit = shift % 32;
+
+				for(int i = 0; i < word; ++i)
+					limbs[i] = 0;
+				limbs[word] = (uint32_t)(value << bit);
+				limbs[word + 1] = (uint32_t)(bit == 0 ? value >> 32 : value >> (32 - bit));
+				limbs[word + 2] = bit == 0 ? 0 : (uint32_t)(value >> (64 - bit));
+				size = word + 3;
+				trim();
+			}
+
+			void multiply(const uint32_t factor)
+			{
+				uint64_t carry = 0;
+				for(int i = 0; i < size; ++i)
+				{
+					const uint64_t product = (uint64_t)limbs[i] * factor + carry;
+					limbs[i] = (uint32_t)product;
+					carry = product >> 32;
+				}
+
+				if(carry != 0)
+					limbs[size++] = (uint32_t)carry;
+			}
+
+			// divides in place, returns the remainder
+			uint32_t divide(const uint32_t divisor)
+			{
+				uint64_t remainder = 0;
+				for(int i = size - 1; i >= 0; --i)
+				{
+					const uint64_t current = (remainder << 32) | limbs[i];
+					limbs[i] = (uint32_t)(current / divisor);
+					remainder = current % divisor;
+				}
+
+				trim();
+				return (uint32_t)remainder;
+			}
+
+			void trim()
+			{
+				while(size > 0 && limbs[size - 1] == 0)
+					--size;
+			}
+
+			uint32_t limbs[MAX_LIMBS];
+			int size;
+		};
+
+		// exact decimal expansion of a double: the integer part, followed by fraction digits generated on demand
+		struct Expansion
+		{
+			explicit Expansion(const double number)
+				: big_integer(false)
+				, integer(0)
+				, fraction_bits(0)
+				, fraction(0)
+				, integer_digits(0)
+				, integer_consumed(0)
+			{
+				uint64_t bits;
+				memcpy(&bits, &number, sizeof(bits));
+
+				negative = (bits >> 63) != 0;
+				const int biased = (int)((bits >> 52) & 0x7ff);
+				uint64_t mantissa = bits & ((1ull << 52) - 1);
+				int exponent = -1074;
+				if(biased != 0)
+				{
+					mantissa |= 1ull << 52;
+					exponent = biased - 1075;
+				}
+
+				if(mantissa == 0)
+					return;
+
+				if(exponent >= 0)
+				{
+					if(exponent <= 11)
+						integer = mantissa << exponent;
+					else
+					{
+						big_integer = true;
+						big.assign_shifted(mantissa, exponent);
+					}
+				}
+				else
+				{
+					fraction_bits = -exponent;
+					if(fraction_bits < 64)
+						integer = mantissa >> fraction_bits;
+
+					if(fraction_bits <= 64)
+						fraction = (fraction_bits == 64 ? mantissa : mantissa & ((1ull << fraction_bits) - 1)) << (64 - fraction_bits);
+					else
+						big.assign_shifted(mantissa, 0);
+				}
+			}
+
+			bool big_fraction() const { return fraction_bits > 64; }
+
+			int next_fraction_digit()
+			{
+				if(big_fraction())
+				{
+					if(big.size == 0)
+						return 0;
+
+					big.multiply(10);
+
+					const int word = fraction_bits / 32;
+					const int bit = fraction_bits % 32;
+					const uint32_t lo = word < big.size ? big.limbs[word] : 0;
+					const uint32_t hi = word + 1 < big.size ? big.limbs[word + 1] : 0;
+					const int digit = (int)((bit == 0 ? lo : (lo >> bit) | (hi << (32 - bit))) & 0xf);
+
+					if(word < big.size)
+					{
+						big.limbs[word] &= bit == 0 ? 0 : (1u << bit) - 1;
+						big.size = word + 1;
+						big.trim();
+					}
+
+					return digit;
+				}
+
+				// multiply the 0.64 fixed point fraction by 10, the digit is whatever overflows
+				const uint64_t lo = (fraction & 0xffffffff) * 10;
+				const uint64_t hi = (fraction >> 32) * 10 + (lo >> 32);
+				fraction = (hi << 32) | (lo & 0xffffffff);
+				return (int)(hi >> 32);
+			}
+
+			// compares the remaining fraction against one half
+			int compare_half() const
+			{
+				if(!big_fraction())
+					return fraction > (1ull << 63) ? 1 : (fraction == (1ull << 63) ? 0 : -1);
+
+				const int word = (fraction_bits - 1) / 32;
+				const int bit = (fraction_bits - 1) % 32;
+				if(word >= big.size || ((big.limbs[word] >> bit) & 1) == 0)
+					return -1;
+
+				if((big.limbs[word] & ((1u << bit) - 1)) != 0)
+					return 1;
+				for(int i = 0; i < word; ++i)
+					if(big.limbs[i] != 0)
+						return 1;
+
+				return 0;
+			}
+
+			bool fraction_is_zero() const
+			{
+				return big_fraction() ? big.size == 0 : fraction == 0;
+			}
+
+			bool integer_is_odd() const
+			{
+				return big_integer ? (big.size > 0 && (big.limbs[0] & 1)) : (integer & 1);
+			}
+
+			// only reachable for numbers with a fraction, which always have a small integer part
+			void increment_integer()
+			{
+				++integer;
+			}
+
+			int integer_length()
+			{
+				if(!big_integer)
+					return Converter::count_digits(integer);
+
+				prepare_integer();
+				return integer_digits;
+			}
+
+			// splits the integer part into base 10^9 chunks, least significant first
+			void prepare_integer()
+			{
+				chunk_count = 0;
+				if(big_integer)
+				{
+					while(big.size > 0)
+						chunks[chunk_count++] = big.divide(1000000000);
+				}
+				else
+				{
+					uint64_t i = integer;
+					while(i != 0)
+					{
+						chunks[chunk_count++] = (uint32_t)(i % 1000000000);
+						i /= 1000000000;
+					}
+				}
+
+				integer_digits = chunk_count == 0 ? 0 : Converter::count_digits(chunks[chunk_count - 1]) + (chunk_count - 1) * 9;
+			}
+
+			void write_integer(Writer &buffer)
+			{
+				if(!big_integer)
+				{
+					char string[20];
+					const int digits = Converter::count_digits(integer);
+					Converter::write_decimal(string + digits, integer);
+					buffer.write(string, digits);
+					return;
+				}
+
+				// chunks were split by integer_length
+				char string[9];
+				const int top = Converter::count_digits(chunks[chunk_count - 1]);
+				Converter::write_decimal(string + top, chunks[chunk_count - 1]);
+				buffer.write(string, top);
+
+				for(int i = chunk_count - 2; i >= 0; --i)
+				{
+					memset(string, '0', sizeof(string));
+					Converter::write_decimal(string + sizeof(string), chunks[i]);
+					buffer.write(string, sizeof(string));
+				}
+			}
+
+			// digit stream over the integer digits (after prepare_integer), then the fraction digits
+			int next_digit()
+			{
+				if(integer_consumed >= integer_digits)
+					return next_fraction_digit();
+
+				return integer_digit(integer_consumed++);
+			}
+
+			// compares everything not yet consumed from the digit stream against one half of the last consumed digit
+			int compare_rest_half()
+			{
+				if(integer_consumed >= integer_digits)
+					return compare_half();
+
+				const int d = integer_digit(integer_consumed++);
+				if(d != 5)
+					return d > 5 ? 1 : -1;
+
+				while(integer_consumed < integer_digits)
+					if(integer_digit(integer_consumed++) != 0)
+						return 1;
+
+				return fraction_is_zero() ? 0 : 1;
+			}
+
+			int integer_digit(const int index) const
+			{
+				static const uint32_t powers_of_10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+				// position counted from the least significant digit
+				const int position = integer_digits - 1 - index;
+				return (int)((chunks[position / 9] / powers_of_10[position % 9]) % 10);
+			}
+
+			bool negative;
+			bool big_integer;
+			uint64_t integer;
+			int fraction_bits;
+			uint64_t fraction; // 0.64 fixed point, when fraction_bits <= 64
+			Bignum big; // integer part when big_integer, fraction scaled by 2^fraction_bits when fraction_bits > 64
+
+			uint32_t chunks[Bignum::MAX_LIMBS];
+			int chunk_count;
+			int integer_digits;
+			int integer_consumed;
+		};
+
+		// Grisu2, by Florian Loitsch ("Printing Floating-Point Numbers Quickly and Accurately with Integers")
+		struct DiyFp
+		{
+			DiyFp(const uint64_t fp, const int exp) : f(fp), e(exp) {}
+
+			explicit DiyFp(const double number)
+			{
+				uint64_t bits;
+				memcpy(&bits, &number, sizeof(bits));
+
+				const int biased = (int)((bits >> 52) & 0x7ff);
+				const uint64_t significand = bits & ((1ull << 52) - 1);
+				if(biased != 0)
+				{
+					f = significand + (1ull << 52);
+					e = biased - 1075;
+				}
+				else
+				{
+					f = significand;
+					e = -1074;
+				}
+			}
+
+			DiyFp operator-(const DiyFp &rhs) const
+			{
+				return DiyFp(f - rhs.f, e);
+			}
+
+			DiyFp operator*(const DiyFp &rhs) const
+			{
+				const uint64_t M32 = 0xffffffff;
+				const uint64_t a = f >> 32;
+				const uint64_t b = f & M32;
+				const uint64_t c = rhs.f >> 32;
+				const uint64_t d = rhs.f & M32;
+				const uint64_t ac = a * c;
+				const uint64_t bc = b * c;
+				const uint64_t ad = a * d;
+				const uint64_t bd = b * d;
+
+				uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+				tmp += 1u << 31; // round
+
+				return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+			}
+
+			DiyFp normalize() const
+			{
+				DiyFp result = *this;
+				const int shift = 64 - Converter::bit_width(f);
+				result.f <<= shift;
+				result.e -= shift;
+				return result;
+			}
+
+			void normalized_boundaries(DiyFp &minus, DiyFp &plus) const
+			{
+				plus = DiyFp((f << 1) + 1, e - 1).normalize();
+				minus = f == (1ull << 52) ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+				minus.f <<= minus.e - plus.e;
+				minus.e = plus.e;
+			}
+
+			uint64_t f;
+			int e;
+		};
+
+		static DiyFp cached_power(const int e, int &K)
+		{
+			static const uint64_t powers_f[] =
+			{
+				0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+				0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+				0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+				0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+				0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+				0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+				0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+				0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+				0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+				0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+				0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+				0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+				0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+				0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+				0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+				0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+				0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+				0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+				0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+				0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+				0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+				0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+				0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+				0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+				0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+				0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+				0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+				0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+				0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull,
+			};
+
+			static const short powers_e[] =
+			{
+				-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+				-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+				-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+				-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+				56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+				375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+				694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+				1013, 1039, 1066,
+			};
+
+			// 10^-348, 10^-340, ..., 10^340
+			const double dk = (-61 - e) * 0.30102999566398114 + 347;
+			int k = (int)dk;
+			if(dk - k > 0.0)
+				++k;
+
+			const unsigned index = (unsigned)((k >> 3) + 1);
+			K = -(-348 + (int)(index << 3));
+
+			return DiyFp(powers_f[index], powers_e[index]);
+		}
+
+		static void grisu_round(char *buffer, const int length, const uint64_t delta, uint64_t rest, const uint64_t ten_kappa, const uint64_t wp_w)
+		{
+			while(rest < wp_w && delta - rest >= ten_kappa && (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+			{
+				--buffer[length - 1];
+				rest += ten_kappa;
+			}
+		}
+
+		static void digit_gen(const DiyFp &W, const DiyFp &Mp, uint64_t delta, char *buffer, int &length, int &K)
+		{
+			static const uint32_t powers_of_10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+			const DiyFp one(1ull << -Mp.e, Mp.e);
+			const DiyFp wp_w = Mp - W;
+			uint32_t p1 = (uint32_t)(Mp.f >> -one.e);
+			uint64_t p2 = Mp.f & (one.f - 1);
+			int kappa = Converter::count_digits(p1);
+			length = 0;
+
+			while(kappa > 0)
+			{
+				// constant divisors, so these compile to multiplications
+				uint32_t d = 0;
+				switch(kappa)
+				{
+					case 10: d = p1 / 1000000000; p1 %= 1000000000; break;
+					case  9: d = p1 /  100000000; p1 %=  100000000; break;
+					case  8: d = p1 /   10000000; p1 %=   10000000; break;
+					case  7: d = p1 /    1000000; p1 %=    1000000; break;
+					case  6: d = p1 /     100000; p1 %=     100000; break;
+					case  5: d = p1 /      10000; p1 %=      10000; break;
+					case  4: d = p1 /       1000; p1 %=       1000; break;
+					case  3: d = p1 /        100; p1 %=        100; break;
+					case  2: d = p1 /         10; p1 %=         10; break;
+					case  1: d = p1;              p1 =           0; break;
+					default: break;
+				}
+
+				if(d != 0 || length != 0)
+					buffer[length++] = (char)('0' + d);
+
+				--kappa;
+				const uint64_t tmp = ((uint64_t)p1 << -one.e) + p2;
+				if(tmp <= delta)
+				{
+					K += kappa;
+					grisu_round(buffer, length, delta, tmp, (uint64_t)powers_of_10[kappa] << -one.e, wp_w.f);
+					return;
+				}
+			}
+
+			for(;;)
+			{
+				p2 *= 10;
+				delta *= 10;
+				const char d = (char)(p2 >> -one.e);
+				if(d != 0 || length != 0)
+					buffer[length++] = '0' + d;
+
+				p2 &= one.f - 1;
+				--kappa;
+				if(p2 < delta)
+				{
+					K += kappa;
+					const int index = -kappa;
+					grisu_round(buffer, length, delta, p2, one.f, wp_w.f * (index < 9 ? powers_of_10[index] : 0));
+					return;
+				}
+			}
+		}
+
+		// the number is digits * 10^K, at most 17 digits
+		static void shortest(const double number, char *digits, int &length, int &K)
+		{
+			if(number == 0.0)
+			{
+				digits[0] = '0';
+				length = 1;
+				K = 0;
+				return;
+			}
+
+			const DiyFp v(number < 0.0 ? -number : number);
+			DiyFp w_m(0, 0);
+			DiyFp w_p(0, 0);
+			v.normalized_boundaries(w_m, w_p);
+
+			const DiyFp c_mk = cached_power(w_p.e, K);
+			const DiyFp W = v.normalize() * c_mk;
+			DiyFp Wp = w_p * c_mk;
+			DiyFp Wm = w_m * c_mk;
+			++Wm.f;
+			--Wp.f;
+
+			digit_gen(W, Wp, Wp.f - Wm.f, digits, length, K);
+		}
+	};
+
+	inline void Converter::float64(Writer &buffer, const double number, const Format &format, int runtime_width, int runtime_precision)
+	{
+		const char point = get_locale().decimal_point;
+		const int precision = runtime_precision == -1 ? format.precision : runtime_precision;
+
+		if(format.general)
+			FloatConverter::general(buffer, number, format, runtime_width, point);
+		else if(format.scientific)
+			FloatConverter::scientific(buffer, number, precision, format, runtime_width, point);
+		else
+			FloatConverter::fixed(buffer, number, precision >= 0 ? precision : 6, format, runtime_width, point);
+	}
+
+	class Parameter
+	{
+	public:
+		enum class Type : unsigned char
+		{
+			NONE,
+			FLOAT64,
+			SIGNED_INT,
+			UNSIGNED_INT,
+			BOOLEAN_,
+			CHARACTER,
+			VOID_POINTER,
+			BUFFER,
+			STRING,
+			FORMATTER,
+			CUSTOM
+		};
+
+		Parameter() : type (Type::NONE) {}
+		Parameter(const Parameter&) = delete;
+		Parameter(Parameter &&other) : type(Type::NONE)
+		{
+			*this = std::move(other);
+		}
+
+		~Parameter()
+		{
+			destroy();
+		}
+
+		// takes over the other parameter's custom string, if it has one
+		Parameter &operator=(Parameter &&other)
+		{
+			if(this == &other)
+				return *this;
+
+			destroy();
+			if(other.type == Type::CUSTOM)
+				new (&object.raw) std::string(std::move(*(std::string*)&other.object.raw));
+			else
+				object = other.object;
+			type = other.type;
+			width = other.width;
+			precision = other.precision;
+
+			return *this;
+		}
+
+		void init(const double d, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::FLOAT64;
+			object.f64 = d;
+		}
+
+		void init(const signed long long i, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::SIGNED_INT;
+			object.lli = i;
+		}
+
+		void init(const unsigned long long i, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::UNSIGNED_INT;
+			object.ulli = i;
+		}
+
+		void init(const bool b, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::BOOLEAN_;
+			object.b = b;
+		}
+
+		void init(const char c, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::CHARACTER;
+			object.c = c;
+		}
+
+		void init(const void *vp, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::VOID_POINTER;
+			object.vp = vp;
+		}
+
+		void init(const char *s, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::BUFFER;
+			object.cstr = s;
+		}
+
+		void init(const str_ref &s, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::STRING;
+			object.str.data = s.data;
+			object.str.length = s.length;
+		}
+
+		void init(void (*fn)(Writer&, const void*, const Format&), const void *obj, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::FORMATTER;
+			object.formatter.fn = fn;
+			object.formatter.object = obj;
+		}
+
+		void init(std::string &&str, const signed char w = -1, const signed char p = -1)
+		{
+			width = w;
+			precision = p;
+			type = Type::CUSTOM;
+			new (&object.raw) std::string(std::move(str));
+		}
+
+		void convert(Writer &buffer, const Format &format) const;
+
+		// copy this parameter into dest (which must not hold a custom type) so that it no longer refers to memory owned by the
+		// caller, any string is copied into [arena, arena_end) and arena is advanced past it. this fails for custom types,
+		// and when the arena is too small
+		bool detach_into(Parameter &dest, char *&arena, const char *const arena_end) const
+		{
+			const char *data;
+			size_t length;
+			switch(type)
+			{
+				case Type::FORMATTER:
+				case Type::CUSTOM:
+					return false;
+				case Type::BUFFER:
+					data = object.cstr;
+					length = strlen(object.cstr);
+					break;
+				case Type::STRING:
+					data = object.str.data;
+					length = object.str.length;
+					break;
+				default:
+					dest.type = type;
+					dest.object = object;
+					dest.width = width;
+					dest.precision = precision;
+					return true;
+			}
+
+			if(length > (size_t)(arena_end - arena))
+				return false;
+
+			memcpy(arena, data, length);
+			dest.init(str_ref(arena, length), width, precision);
+			arena += length;
+			return true;
+		}
+
+		// binary encoding used by press::binary_log: a type byte, then the width and precision bytes (only if either is set,
+		// flagged by USER_SPEC in the type byte), then the value. integers are stored as varints (zigzag for signed), strings as a
+		// varint length followed by their bytes. returns 0 for parameters that can't be encoded (format_to types)
+		static constexpr unsigned char USER_SPEC = 0x80;
+
+		size_t encoded_size() const
+		{
+			const size_t header = (width == -1 && precision == -1) ? 1 : 3;
+			switch(type)
+			{
+				case Type::FORMATTER:
+					return 0;
+				case Type::BUFFER:
+					return header + string_size(strlen(object.cstr));
+				case Type::STRING:
+					return header + string_size(object.str.length);
+				case Type::CUSTOM:
+					return header + string_size(((const std::string*)&object.raw)->length());
+				case Type::BOOLEAN_:
+				case Type::CHARACTER:
+					return header + 1;
+				case Type::SIGNED_INT:
+					return header + varint_size(zigzag(object.lli));
+				case Type::UNSIGNED_INT:
+					return header + varint_size(object.ulli);
+				case Type::VOID_POINTER:
+					return header + varint_size((uintptr_t)object.vp);
+				case Type::FLOAT64:
+					return header + 8;
+				default:
+					return header;
+			}
+		}
+
+		// out must have room for encoded_size() bytes, returns the end of the encoding
+		char *encode(char *out) const
+		{
+			// C strings are stored the same as any other string
+			const bool user_spec = width != -1 || precision != -1;
+			*out++ = (char)((unsigned char)(type == Type::BUFFER ? Type::STRING : type) | (user_spec ? USER_SPEC : 0));
+			if(user_spec)
+			{
+				*out++ = (char)width;
+				*out++ = (char)precision;
+			}
+
+			switch(type)
+			{
+				case Type::BUFFER:
+					return encode_string(out, object.cstr, strlen(object.cstr));
+				case Type::STRING:
+					return encode_string(out, object.str.data, object.str.length);
+				case Type::CUSTOM:
+				{
+					const std::string &str = *(const std::string*)&object.raw;
+					return encode_string(out, str.data(), str.length());
+				}
+				case Type::BOOLEAN_:
+					*out = object.b;
+					return out + 1;
+				case Type::CHARACTER:
+					*out = object.c;
+					return out + 1;
+				case Type::SIGNED_INT:
+					return encode_varint(out, zigzag(object.lli));
+				case Type::UNSIGNED_INT:
+					return encode_varint(out, object.ulli);
+				case Type::VOID_POINTER:
+					return encode_varint(out, (uintptr_t)object.vp);
+				case Type::FLOAT64:
+					memcpy(out, &object.f64, 8);
+					return out + 8;
+				default:
+					return out;
+			}
+		}
+
+		static inline unsigned long long zigzag(const long long i)
+		{
+			return ((unsigned long long)i << 1) ^ (unsigned long long)(i >> 63);
+		}
+
+		static inline long long unzigzag(const unsigned long long u)
+		{
+			return (long long)(u >> 1) ^ -(long long)(u & 1);
+		}
+
+		static inline size_t varint_size(unsigned long long u)
+		{
+			size_t size = 1;
+			while(u >= 0x80)
+			{
+				u >>= 7;
+				++size;
+			}
+
+			return size;
+		}
+
+		static inline char *encode_varint(char *out, unsigned long long u)
+		{
+			while(u >= 0x80)
+			{
+				*out++ = (char)(u | 0x80);
+				u >>= 7;
+			}
+
+			*out++ = (char)u;
+			return out;
+		}
+
+		static inline size_t string_size(const size_t length)
+		{
+			return varint_size(length) + length;
+		}
+
+		static inline char *encode_string(char *out, const char *str, const size_t length)
+		{
+			out = encode_varint(out, length);
+			memcpy(out, str, length);
+			return out + length;
+		}
+
+	private:
+		void destroy()
+		{
+			if(type == Type::CUSTOM)
+			{
+				typedef std::string sstring;
+				sstring *s = (sstring*)&object.raw;
+				s->~sstring();
+			}
+
+			type = Type::NONE;
+		}
+
+		Type type;
+		union
+		{
+			long long lli;
+			unsigned long long ulli;
+			double f64;
+			char c;
+			const void *vp;
+			bool b;
+			const char *cstr;
+			struct
+			{
+				const char *data;
+				size_t length;
+			} str;
+			struct
+			{
+				void (*fn)(Writer&, const void*, const Format&);
+				const void *object;
+			} formatter;
+			std::aligned_storage<sizeof(std::string), alignof(std::string)>::type raw;
+		} object;
+		signed char width;
+		signed char precision;
+	};
+
+	#ifdef PRESS_CORE_DEFINITIONS
+	PRESS_CORE void Parameter::convert(Writer &buffer, const Format &format) const
+	{
+		switch(type)
+		{
+			case Type::SIGNED_INT:
+				Converter::integer<long long>(buffer, object.lli, format, (int)width);
+				break;
+			case Type::UNSIGNED_INT:
+				Converter::integer<unsigned long long>(buffer, object.ulli, format, (int)width);
+				break;
+			case Type::BUFFER:
+				Converter::string(buffer, object.cstr, format, (int)width, (int)precision);
+				break;
+			case Type::STRING:
+				Converter::string(buffer, str_ref(object.str.data, object.str.length), format, (int)width, (int)precision);
+				break;
+			case Type::CHARACTER:
+				Converter::character(buffer, object.c, format, (int)width);
+				break;
+			case Type::FLOAT64:
+				Converter::float64(buffer, object.f64, format, (int)width, (int)precision);
+				break;
+			case Type::BOOLEAN_:
+				Converter::boolean(buffer, object.b, format, (int)width);
+				break;
+			case Type::VOID_POINTER:
+				Converter::pointer(buffer, object.vp, format, (int)width);
+				break;
+			case Type::FORMATTER:
+				Converter::formatter(buffer, object.formatter.fn, object.formatter.object, format, (int)width, (int)precision);
+				break;
+			case Type::CUSTOM:
+				Converter::custom(buffer, *(const std::string*)&object.raw, format, (int)width);
+				break;
+			default:
+				break;
+		}
+	}
+	#endif
+
+	constexpr bool is_literal_brace(const char *fmt, int len, int index)
+	{
+		return
+		(index > len - 3) ?
+			(false)
+			: (fmt[index] == '{' && fmt[index + 1] == '{' && fmt[index + 2] == '}');
+	}
+
+	#ifdef PRESS_HAS_CONSTEXPR_LOOPS
+	// the scanners below as loops, which compile much faster than the recursive C++11 versions and don't run
+	// into the constexpr depth limit on long format strings
+	constexpr bool is_balanced(const char *fmt, int len, int index = 0, int open = 0)
+	{
+		while(index < len)
+		{
+			if(is_literal_brace(fmt, len, index))
+			{
+				index += 3;
+				continue;
+			}
+
+			if(fmt[index] == '{')
+				++open;
+			else if(fmt[index] == '}' && open > 0)
+				--open;
+
+			++index;
+		}
+
+		return open == 0;
+	}
+
+	constexpr int find_partner(const char *fmt, int len, int index)
+	{
+		for(; index < len; ++index)
+		{
+			if(fmt[index] == '}')
+				return index;
+		}
+
+		return -1;
+	}
+
+	constexpr int count_specifiers(const char *fmt, int len, int count = 0, int index = 0)
+	{
+		while(index < len)
+		{
+			if(fmt[index] != '{')
+			{
+				++index;
+			}
+			else if(is_literal_brace(fmt, len, index))
+			{
+				index += 3;
+			}
+			else
+			{
+				const int partner = find_partner(fmt, len, index + 1);
+				if(partner == -1)
+					return count;
+
+				++count;
+				index = partner + 1;
+			}
+		}
+
+		return count;
+	}
+
+	// upper bound on the number of segments a format string compiles to (one per opening brace, plus the tail)
+	constexpr int count_segments(const char *fmt, int len, int index = 0, int count = 1)
+	{
+		for(; index < len; ++index)
+			count += fmt[index] == '{';
+
+		return count;
+	}
+	#else
+	constexpr bool is_balanced(const char *fmt, int len, int index = 0, int open = 0)
+	{
+		return
+			(index >= len) ?
+				(open == 0)
+				: ((fmt[index] == '{') ?
+					(is_literal_brace(fmt, len, index) ?
+						(is_balanced(fmt, len, index + 3, open))
+						: (is_balanced(fmt, len, index + 1, open + 1)))
+					: ((fmt[index] == '}') ?
+						((open > 0) ?
+							(is_balanced(fmt, len, index + 1, open - 1))
+							: (is_balanced(fmt, len, index + 1, open)))
+						: (is_balanced(fmt, len, index + 1, open))));
+	}
+
+	constexpr int find_partner(const char *fmt, int len, int index)
+	{
+		return
+		(index >= len) ?
+			(-1)
+			: ((fmt[index] == '}') ?
+				(index)
+				: (find_partner(fmt, len, index + 1)));
+	}
+
+	constexpr int count_specifiers(const char *fmt, int len, int count = 0, int index = 0)
+	{
+		return
+		(index >= len) ?
+			(count)
+			: ((fmt[index] != '{') ?
+				(count_specifiers(fmt, len, count, index + 1))
+				: ((is_literal_brace(fmt, len, index)) ?
+					(count_specifiers(fmt, len, count, index + 3))
+					: ((find_partner(fmt, len, index + 1) == -1) ?
+						(count)
+						: (count_specifiers(fmt, len, count + 1, find_partner(fmt, len, index + 1) + 1)))));
+	}
+
+	// upper bound on the number of segments a format string compiles to (one per opening brace, plus the tail)
+	constexpr int count_segments(const char *fmt, int len, int index = 0, int count = 1)
+	{
+		return
+		(index >= len) ?
+			(count)
+			: (count_segments(fmt, len, index + 1, count + (fmt[index] == '{')));
+	}
+	#endif
+
+	// compile time specifier checking, used by pressfmtcheck_args
+	namespace impl{
+	enum format_check { CHECK_OK, CHECK_MALFORMED, CHECK_INDEX, CHECK_TYPE };
+
+	// what a parameter can be, as far as the representation flags are concerned
+	enum arg_kind_value { KIND_OTHER, KIND_SIGNED, KIND_UNSIGNED, KIND_FLOAT, KIND_STRING, KIND_BOOL, KIND_CHAR, KIND_POINTER };
+
+	// user defined types, ranges and byte buffers interpret the flags themselves, so they accept everything. char* prints as
+	// a string like const char*, but signed char* and unsigned char* print as pointers
+	template <typename T> struct arg_kind
+	{
+		constexpr static int value =
+			std::is_same<T, bool>::value ? KIND_BOOL
+			: std::is_same<T, char>::value ? KIND_CHAR
+			: std::is_floating_point<T>::value ? KIND_FLOAT
+			: (std::is_integral<T>::value && std::is_unsigned<T>::value) ? KIND_UNSIGNED
+			: (std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) > 1) ? KIND_SIGNED
+			: (std::is_same<T, const char*>::value || std::is_same<T, char*>::value || std::is_same<T, std::string>::value || std::is_same<T, str_ref>::value) ? KIND_STRING
+			: std::is_pointer<T>::value ? KIND_POINTER
+			: KIND_OTHER;
+	};
+
+	#ifdef PRESS_HAS_STRING_VIEW
+	template <> struct arg_kind<std::string_view> { constexpr static int value = KIND_STRING; };
+	#endif
+
+	// runtime width and precision are checked as the parameter they wrap
+	template <typename T> struct arg_kind<width_spec<T>> : arg_kind<T> {};
+	template <typename T> struct arg_kind<precision_spec<T>> : arg_kind<T> {};
+	template <typename T> struct arg_kind<width_precision_spec<T>> : arg_kind<T> {};
+
+	// the kind of every parameter, by index
+	template <typename... Ts> struct kind_list
+	{
+		constexpr static int get(int) { return KIND_OTHER; }
+	};
+
+	template <typename T, typename... Ts> struct kind_list<T, Ts...>
+	{
+		constexpr static int get(int index) { return index == 0 ? arg_kind<T>::value : kind_list<Ts...>::get(index - 1); }
+	};
+
+	template <typename Tuple> struct tuple_kinds;
+	template <typename... Ts> struct tuple_kinds<std::tuple<Ts...>> : kind_list<Ts...> {};
+
+	// a specifier parsed at compile time
+	struct spec_info
+	{
+		constexpr spec_info(int e, char r, bool a, int i) : end(e), representation(r), alternate(a), index(i) {}
+
+		int end; // the closing bracket, -1 if the specifier is malformed
+		char representation; // x, X, o, g, e or 0
+		bool alternate;
+		int index; // from the '@' flag (starts at 1), -1 if there isn't one
+	};
+
+	constexpr bool is_digit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	constexpr int skip_digits(const char *fmt, int len, int index)
+	{
+		return (index < len && is_digit(fmt[index])) ? (skip_digits(fmt, len, index + 1)) : (index);
+	}
+
+	// the value of the number at index, stops growing past 1000 so it can't overflow
+	constexpr int number_value(const char *fmt, int len, int index, int value = 0)
+	{
+		return
+		(index < len && is_digit(fmt[index])) ?
+			(number_value(fmt, len, index + 1, value > 1000 ? value : value * 10 + (fmt[index] - '0')))
+			: (value);
+	}
+
+	// widths, precisions and indices are stored as signed char
+	constexpr bool number_fits(const char *fmt, int len, int index)
+	{
+		return number_value(fmt, len, index) <= 127;
+	}
+
+	// the stages below follow Format::parse: alignment, sign, separator, padding, alternate, representation, width, precision, index
+	constexpr spec_info spec_close(const char *fmt, int len, int index, char representation, bool alternate, int param)
+	{
+		return spec_info((index < len && fmt[index] == '}') ? index : -1, representation, alternate, param);
+	}
+
+	constexpr spec_info spec_index(const char *fmt, int len, int index, char representation, bool alternate)
+	{
+		return
+		(index >= len || fmt[index] != '@') ?
+			(spec_close(fmt, len, index, representation, alternate, -1))
+			: (!number_fits(fmt, len, index + 1)) ?
+				(spec_info(-1, representation, alternate, -1))
+				: (spec_close(fmt, len, skip_digits(fmt, len, index + 1), representation, alternate,
+					skip_digits(fmt, len, index + 1) > index + 1 ? number_value(fmt, len, index + 1) : -1));
+	}
+
+	constexpr spec_info spec_precision(const char *fmt, int len, int index, char representation, bool alternate)
+	{
+		return
+		(index >= len || fmt[index] != '.') ?
+			(spec_index(fmt, len, index, representation, alternate))
+			: (!number_fits(fmt, len, index + 1)) ?
+				(spec_info(-1, representation, alternate, -1))
+				: (spec_index(fmt, len, skip_digits(fmt, len, index + 1), representation, alternate));
+	}
+
+	constexpr spec_info spec_width(const char *fmt, int len, int index, char representation, bool alternate)
+	{
+		return
+		(!number_fits(fmt, len, index)) ?
+			(spec_info(-1, representation, alternate, -1))
+			: (spec_precision(fmt, len, skip_digits(fmt, len, index), representation, alternate));
+	}
+
+	constexpr bool is_representation(char c)
+	{
+		return c == 'x' || c == 'X' || c == 'o' || c == 'g' || c == 'e';
+	}
+
+	constexpr spec_info spec_representation(const char *fmt, int len, int index, bool alternate)
+	{
+		return
+		(index < len && is_representation(fmt[index])) ?
+			(spec_width(fmt, len, index + 1, fmt[index], alternate))
+			: (spec_width(fmt, len, index, 0, alternate));
+	}
+
+	constexpr int skip_flag(const char *fmt, int len, int index, char a, char b)
+	{
+		return (index < len && (fmt[index] == a || fmt[index] == b)) ? (index + 1) : (index);
+	}
+
+	constexpr spec_info spec_alternate(const char *fmt, int len, int index)
+	{
+		return
+		(index < len && fmt[index] == '#') ?
+			(spec_representation(fmt, len, index + 1, true))
+			: (spec_representation(fmt, len, index, false));
+	}
+
+	constexpr bool is_align(char c)
+	{
+		return c == '<' || c == '>' || c == '^';
+	}
+
+	// a fill character (anything but a brace) and an alignment, or just an alignment
+	constexpr int skip_align(const char *fmt, int len, int index)
+	{
+		return
+		(index + 1 < len && is_align(fmt[index + 1]) && fmt[index] != '{' && fmt[index] != '}') ?
+			(index + 2)
+			: (index < len && is_align(fmt[index])) ?
+				(index + 1)
+				: (index);
+	}
+
+	// index is just past the opening bracket
+	constexpr spec_info parse_spec(const char *fmt, int len, int index)
+	{
+		return spec_alternate(fmt, len, skip_flag(fmt, len, skip_flag(fmt, len, skip_flag(fmt, len, skip_align(fmt, len, index), ' ', ' '), ',', ','), '0', '-'));
+	}
+
+	// x and X apply to unsigned integers and pointers, o to unsigned integers, e and g to floating point, # needs a base
+	constexpr bool spec_fits(int kind, char representation, bool alternate)
+	{
+		return
+		(kind == KIND_OTHER) ?
+			(true)
+			: (representation == 'x' || representation == 'X') ?
+				(kind == KIND_UNSIGNED || kind == KIND_POINTER)
+				: (representation == 'o') ?
+					(kind == KIND_UNSIGNED)
+					: (representation == 'e' || representation == 'g') ?
+						(kind == KIND_FLOAT && !alternate)
+						: (!alternate || kind == KIND_POINTER);
+	}
+
+	#ifdef PRESS_HAS_CONSTEXPR_LOOPS
+	// every specifier must be well formed, refer to an existing parameter (sequentially or through '@') and suit its type
+	template <typename Kinds> constexpr int check_format(const char *fmt, int len, int count, int index = 0, int spec = 0)
+	{
+		while(index < len)
+		{
+			if(fmt[index] != '{')
+			{
+				++index;
+				continue;
+			}
+
+			if(is_literal_brace(fmt, len, index))
+			{
+				index += 3;
+				continue;
+			}
+
+			const spec_info info = parse_spec(fmt, len, index + 1);
+			if(info.end < 0)
+				return CHECK_MALFORMED;
+
+			const int param = info.index > 0 ? info.index - 1 : spec;
+			if(info.index == 0 || param >= count)
+				return CHECK_INDEX;
+
+			if(!spec_fits(Kinds::get(param), info.representation, info.alternate))
+				return CHECK_TYPE;
+
+			index = info.end + 1;
+			++spec;
+		}
+
+		return CHECK_OK;
+	}
+	#else
+	template <typename Kinds> constexpr int check_spec(const char *fmt, int len, int count, int spec, spec_info info);
+
+	// every specifier must be well formed, refer to an existing parameter (sequentially or through '@') and suit its type
+	template <typename Kinds> constexpr int check_format(const char *fmt, int len, int count, int index = 0, int spec = 0)
+	{
+		return
+		(index >= len) ?
+			(CHECK_OK)
+			: (fmt[index] != '{') ?
+				(check_format<Kinds>(fmt, len, count, index + 1, spec))
+				: (is_literal_brace(fmt, len, index)) ?
+					(check_format<Kinds>(fmt, len, count, index + 3, spec))
+					: (check_spec<Kinds>(fmt, len, count, spec, parse_spec(fmt, len, index + 1)));
+	}
+
+	template <typename Kinds> constexpr int check_spec(const char *fmt, int len, int count, int spec, spec_info info)
+	{
+		return
+		(info.end < 0) ?
+			(CHECK_MALFORMED)
+			: (info.index == 0 || (info.index > 0 ? info.index : spec + 1) > count) ?
+				(CHECK_INDEX)
+				: (!spec_fits(Kinds::get(info.index > 0 ? info.index - 1 : spec), info.representation, info.alternate)) ?
+					(CHECK_TYPE)
+					: (check_format<Kinds>(fmt, len, count, info.end + 1, spec + 1));
+	}
+	#endif
+	}
+
+	namespace impl{
+	inline int lowest_set_bit(const unsigned long long mask)
+	{
+	#if defined (__GNUC__)
+		return __builtin_ctzll(mask);
+	#elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_ARM64))
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return (int)index;
+	#else
+		int index = 0;
+		while(((mask >> index) & 1) == 0)
+			++index;
+		return index;
+	#endif
+	}
+
+	// index of the first '{' in fmt at or after index, or len if there isn't one. runtime format strings are scanned with this
+	// 16 or 32 bytes at a time
+	inline int find_brace(const char *const fmt, int index, const int len)
+	{
+	#ifdef PRESS_SIMD_AVX2
+		const __m256i braces32 = _mm256_set1_epi8('{');
+		for(; index + 32 <= len; index += 32)
+		{
+			const unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(fmt + index)), braces32));
+			if(mask != 0)
+				return index + lowest_set_bit(mask);
+		}
+	#endif
+
+	#if defined (PRESS_SIMD_SSE2)
+		const __m128i braces = _mm_set1_epi8('{');
+		for(; index + 16 <= len; index += 16)
+		{
+			const unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(fmt + index)), braces));
+			if(mask != 0)
+				return index + lowest_set_bit(mask);
+		}
+	#elif defined (PRESS_SIMD_NEON)
+		const uint8x16_t braces = vdupq_n_u8('{');
+		for(; index + 16 <= len; index += 16)
+		{
+			// narrow the 16 byte comparison to 4 bits per byte
+			const uint8x16_t matches = vceqq_u8(vld1q_u8((const uint8_t*)(fmt + index)), braces);
+			const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+			if(mask != 0)
+				return index + lowest_set_bit(mask) / 4;
+		}
+	#else
+		if(index < len)
+		{
+			const char *const found = (const char*)memchr(fmt + index, '{', len - index);
+			return found == NULL ? len : found - fmt;
+		}
+	#endif
+
+		while(index < len && fmt[index] != '{')
+			++index;
+
+		return index;
+	}
+
+	// same as count_specifiers, for format strings that are only known at runtime
+	inline int count_specifiers_runtime(const char *const fmt, const int len)
+	{
+		int count = 0;
+		int index = 0;
+		for(;;)
+		{
+			index = find_brace(fmt, index, len);
+			if(index >= len)
+				return count;
+
+			if(is_literal_brace(fmt, len, index))
+			{
+				index += 3;
+				continue;
+			}
+
+			const char *const partner = (const char*)memchr(fmt + index + 1, '}', len - index - 1);
+			if(partner == NULL)
+				return count;
+
+			++count;
+			index = partner - fmt + 1;
+		}
+	}
+	}
+
+	// a run of literal text from the format string, optionally followed by a pre-parsed specifier
+	struct compiled_segment
+	{
+		int literal_begin;
+		int literal_length;
+		bool has_spec;
+		int index; // parameter index, starts at 0
+		Format format;
+	};
+
+	class compiled_format
+	{
+	public:
+		compiled_format(const compiled_format&) = delete;
+		compiled_format(compiled_format&&) = delete;
+
+		bool compiled() const { return segment_count >= 0; }
+
+		// a small number unique to this compiled format (starting at 1), assigned on first use, used by press::binary_log
+		int id() const
+		{
+			int current = m_id.load(std::memory_order_acquire);
+			if(current == 0)
+			{
+				static std::atomic<int> next(1);
+				const int assigned = next.fetch_add(1, std::memory_order_relaxed);
+				current = m_id.compare_exchange_strong(current, assigned, std::memory_order_acq_rel) ? assigned : current;
+			}
+
+			return current;
+		}
+
+		const char *const fmt;
+		const int fmt_len;
+		const compiled_segment *const segments;
+		int segment_count; // -1 if the format string did not fit in the segment storage
+		const bool trusted; // checked against its parameters at compile time (prcompile_trusted), every index is in range
+		const bool persistent; // static storage from prcompile over a literal, so it outlives every call, see write_async
+
+	protected:
+		compiled_format(const char *f, compiled_segment *storage, bool t, bool p)
+			: fmt(f)
+			, fmt_len(strlen(f))
+			, segments(storage)
+			, segment_count(-1)
+			, trusted(t)
+			, persistent(p)
+			, m_id(0)
+		{}
+
+		// walks the format string exactly like impl::printer does, but records segments instead of writing output
+		void compile(compiled_segment *const storage, const int capacity);
+
+	private:
+		mutable std::atomic<int> m_id;
+	};
+
+	#ifdef PRESS_CORE_DEFINITIONS
+	PRESS_CORE void compiled_format::compile(compiled_segment *const storage, const int capacity)
+	{
+		const int spec_count = impl::count_specifiers_runtime(fmt, fmt_len);
+
+		int count = 0;
+		int bookmark = 0;
+		for(int k = 0; k < spec_count; ++k)
+		{
+			const int spec_begin = impl::find_brace(fmt, bookmark, fmt_len);
+
+			if(spec_begin >= fmt_len)
+			{
+				segment_count = count;
+				return;
+			}
+
+			if(count >= capacity)
+				return;
+
+			compiled_segment &seg = storage[count++];
+			seg.literal_begin = bookmark;
+			seg.format.reset();
+
+			if(is_literal_brace(fmt, fmt_len, spec_begin))
+			{
+				// keep the first brace of the "{{}" pattern as part of the literal run
+				seg.literal_length = (spec_begin + 1) - bookmark;
+				seg.has_spec = false;
+				seg.index = -1;
+				bookmark = spec_begin + 3;
+				--k;
+				continue;
+			}
+
+			seg.literal_length = spec_begin - bookmark;
+			seg.has_spec = true;
+			bookmark = Format::parse(fmt, spec_begin + 1, fmt_len, seg.format) + 1;
+			seg.index = seg.format.index >= 0 ? seg.format.index - 1 : k;
+		}
+
+		// the "tail"
+		while(bookmark < fmt_len)
+		{
+			int index = impl::find_brace(fmt, bookmark, fmt_len);
+			while(index < fmt_len && !is_literal_brace(fmt, fmt_len, index))
+				index = impl::find_brace(fmt, index + 1, fmt_len);
+
+			if(count >= capacity)
+				return;
+
+			compiled_segment &seg = storage[count++];
+			seg.literal_begin = bookmark;
+			seg.has_spec = false;
+			seg.index = -1;
+			seg.format.reset();
+
+			if(index >= fmt_len)
+			{
+				seg.literal_length = fmt_len - bookmark;
+				break;
+			}
+
+			seg.literal_length = (index + 1) - bookmark;
+			bookmark = index + 3;
+		}
+
+		segment_count = count;
+	}
+	#endif
+
+	// storage for a compiled format string, sized by count_segments
+	template <int N> class compiled_format_storage : public compiled_format
+	{
+	public:
+		explicit compiled_format_storage(const char *f, bool trusted = false, bool persistent = false)
+			: compiled_format(f, m_storage, trusted, persistent)
+		{
+			compile(m_storage, N);
+		}
+
+	private:
+		compiled_segment m_storage[N];
+	};
+
+	// accepted by all printing interfaces, either a plain format string (parsed on every call) or a compiled one
+	class format_string
+	{
+	public:
+		format_string(const char *f) : fmt(f), compiled(NULL) {}
+		format_string(const compiled_format &cf) : fmt(cf.fmt), compiled(cf.compiled() ? &cf : NULL) {}
+
+		const char *const fmt;
+		const compiled_format *const compiled;
+	};
+
+#ifdef PRESS_FORMAT_CACHE
+	// a small per-thread table of compiled runtime format strings, used by all printing interfaces when PRESS_FORMAT_CACHE is
+	// defined so that formats that aren't literals are only parsed once. entries own a copy of their format string and are
+	// checked against it on every lookup, so a buffer that is changed or reused never gets a stale entry. by default the table is
+	// indexed by the format's address, define PRESS_FORMAT_CACHE_BY_CONTENT to index it by a hash of the format's contents instead,
+	// for formats that are rebuilt in a different buffer for every call
+	class format_cache
+	{
+		struct entry;
+
+	public:
+		static constexpr int ENTRY_COUNT = 64; // must be a power of 2
+		static constexpr int MAX_SEGMENTS = 32; // formats with more segments are parsed on every call
+
+		// holds the compiled form of fmt (or NULL if it couldn't be compiled) for as long as it is printing. a pinned entry is
+		// never replaced, so a nested call on the same thread (from inside a format_to) that lands on it goes uncached
+		class pin
+		{
+		public:
+			explicit pin(const char *const fmt) : m_entry(find(fmt))
+			{
+				if(m_entry != NULL)
+					++m_entry->users;
+			}
+
+			pin(const pin&) = delete;
+			~pin()
+			{
+				if(m_entry != NULL)
+					--m_entry->users;
+			}
+
+			const compiled_format *get() const { return m_entry != NULL ? m_entry->compiled.get() : NULL; }
+
+		private:
+			entry *const m_entry;
+		};
+
+		// drop all of the calling thread's entries, except those still printing
+		static void clear()
+		{
+			for(int i = 0; i < ENTRY_COUNT; ++i)
+			{
+				if(entries()[i].users > 0)
+					continue;
+
+				entries()[i].compiled.reset();
+				entries()[i].text.clear();
+			}
+		}
+
+	private:
+		struct entry
+		{
+			entry() : users(0) {}
+
+			std::string text;
+			std::unique_ptr<compiled_format_storage<MAX_SEGMENTS>> compiled;
+			int users; // pins of this entry that are printing
+		};
+
+		// the entry holding the compiled form of fmt, or NULL if it couldn't be compiled or its slot is pinned by another format
+		static entry *find(const char *const fmt)
+		{
+			const size_t len = strlen(fmt);
+		#ifdef PRESS_FORMAT_CACHE_BY_CONTENT
+			unsigned long long hash = 14695981039346656037ull;
+			for(size_t i = 0; i < len; ++i)
+				hash = (hash ^ (unsigned char)fmt[i]) * 1099511628211ull;
+		#else
+			const unsigned long long hash = (unsigned long long)(uintptr_t)fmt * 11400714819323198485ull;
+		#endif
+
+			entry &e = entries()[(hash >> 32) & (ENTRY_COUNT - 1)];
+			if(e.compiled == NULL || e.text.length() != len || memcmp(e.text.data(), fmt, len) != 0)
+			{
+				if(e.users > 0)
+					return NULL;
+
+				// replace whatever was there
+				e.compiled.reset();
+				e.text.assign(fmt, len);
+				e.compiled.reset(new compiled_format_storage<MAX_SEGMENTS>(e.text.c_str()));
+			}
+
+			return e.compiled->compiled() ? &e : NULL;
+		}
+
+		static entry *entries()
+		{
+			static thread_local entry table[ENTRY_COUNT];
+			return table;
+		}
+	};
+#endif
+
+	template <typename T> std::string to_string(const T&)
+	{
+		return "{UNKNOWN DATA TYPE}";
+	}
+
+	namespace impl{
+	// detects a user provided "void format_to(press::Writer&, const T&, const press::Format&)", found through
+	// argument dependent lookup, which is preferred over press::to_string because it doesn't allocate
+	template <typename T> struct has_format_to
+	{
+		template <typename U> static auto test(int) -> decltype(format_to(std::declval<Writer&>(), std::declval<const U&>(), std::declval<const Format&>()), std::true_type());
+		template <typename U> static std::false_type test(...);
+
+		constexpr static bool value = decltype(test<T>(0))::value;
+	};
+
+	template <typename T> void format_to_trampoline(Writer &output, const void *object, const Format &format)
+	{
+		format_to(output, *(const T*)object, format);
+	}
+	}
+
+	namespace impl{
+	// argument source for the printers: the type-erased Parameter array built by impl::write
+	struct erased_args
+	{
+		erased_args(const Parameter *const p, const int s) : params(p), pack_size(s) {}
+
+		int size() const { return pack_size; }
+		void convert(const int index, Writer &output, const Format &format) const { params[index].convert(output, format); }
+
+		const Parameter *const params;
+		const int pack_size;
+	};
+
+	template <typename Args> inline void printer(const char *const fmt, const Args &args, Writer &output)
+	{
+		const int pack_size = args.size();
+		const int fmt_len = strlen(fmt);
+		const int spec_count = count_specifiers_runtime(fmt, fmt_len);
+
+		// begin printing
+		int bookmark = 0;
+		for(int k = 0; k < spec_count; ++k)
+		{
+			// find the first open specifier bracket and extract the spec
+			const int spec_begin = find_brace(fmt, bookmark, fmt_len);
+			if(spec_begin >= fmt_len)
+				return;
+
+			// print the "before" text
+			output.write_ref(fmt + bookmark, spec_begin - bookmark);
+			if(is_literal_brace(fmt, fmt_len, spec_begin))
+			{
+				output.write("{", 1);
+				bookmark = spec_begin + 3;
+				--k;
+				continue;
+			}
+
+			Format format_settings;
+			bookmark = Format::parse(fmt, spec_begin + 1, fmt_len, format_settings) + 1;
+
+			const bool spec_index_overridden = format_settings.index >= 0;
+			const int index = spec_index_overridden ? format_settings.index - 1 : k;
+			if(spec_index_overridden && (index < 0 || index >= (int)pack_size))
+				output.write("{UNDEFINED}", 11);
+			else if(!spec_index_overridden && index >= (int)pack_size)
+				output.write("{UNDEFINED}", 11);
+			else
+				args.convert(index, output, format_settings);
+		}
+
+		// print the "tail"
+		if(bookmark < fmt_len)
+		{
+			// look for literal brace patterns
+			for(;;)
+			{
+				int index = find_brace(fmt, bookmark, fmt_len);
+				while(index < fmt_len && !is_literal_brace(fmt, fmt_len, index))
+					index = find_brace(fmt, index + 1, fmt_len);
+
+				if(index >= fmt_len)
+					break;
+
+				// print the text before the brace pattern
+				output.write_ref(fmt + bookmark, index - bookmark);
+
+				// print a literal brace
+				const char brace = '{';
+				output.write(&brace, 1);
+
+				bookmark = index + 3;
+			}
+
+			// write the last little bit
+			output.write_ref(fmt + bookmark, fmt_len - bookmark);
+		}
+	}
+
+	template <bool Trusted, typename Args> inline void print_segments(const compiled_format &cf, const Args &args, Writer &output)
+	{
+		const int pack_size = args.size();
+		for(int i = 0; i < cf.segment_count; ++i)
+		{
+			const compiled_segment &seg = cf.segments[i];
+
+			output.write_ref(cf.fmt + seg.literal_begin, seg.literal_length);
+
+			if(!seg.has_spec)
+				continue;
+
+			if(!Trusted && (seg.index < 0 || seg.index >= pack_size))
+				output.write("{UNDEFINED}", 11);
+			else
+				args.convert(seg.index, output, seg.format);
+		}
+	}
+
+	template <typename Args> inline void printer(const compiled_format &cf, const Args &args, Writer &output)
+	{
+		if(cf.trusted)
+			print_segments<true>(cf, args, output);
+		else
+			print_segments<false>(cf, args, output);
+	}
+
+	template <typename T> struct is_pointer
+	{
+		constexpr static bool value = std::is_pointer<T>::value || std::is_member_pointer<T>::value || std::is_member_object_pointer<T>::value || std::is_member_function_pointer<T>::value || std::is_function<typename std::remove_pointer<T>::type>::value;
+	};
+
+	// dummy primary template
+	template <typename T> inline void add_ptr(const typename std::enable_if<!is_pointer<T>::value, T>::type&, Parameter*, int&, signed char, signed char) {}
+
+	// catch pointers
+	template <typename T> inline void add_ptr(const typename std::enable_if<is_pointer<T>::value, T>::type& vp, Parameter *array, int &index, signed char w = -1, signed char p = -1)
+	{
+		array[index++].init((void*)vp, w, p);
+	}
+
+	// user defined types, by reference to a format_to overload if there is one, otherwise by value through to_string
+	template <typename T> inline void add_custom(const typename std::enable_if<has_format_to<T>::value, T>::type &x, Parameter *array, int &index, signed char w, signed char p)
+	{
+		array[index++].init(&format_to_trampoline<T>, (const void*)&x, w, p);
+	}
+
+	template <typename T> inline void add_custom(const typename std::enable_if<!has_format_to<T>::value, T>::type &x, Parameter *array, int &index, signed char w, signed char p)
+	{
+	#ifdef PRESS_STATS
+		count(global_stats().allocations);
+	#endif
+		array[index++].init(std::move(press::to_string(x)), w, p);
+	}
+
+	template <typename T> inline void add(const T &x, Parameter *array, int &index, signed char w = -1, signed char p = -1)
+	{
+		if(is_pointer<T>::value)
+		{
+			add_ptr<T>(x, array, index, w, p);
+		}
+		else
+		{
+			add_custom<T>(x, array, index, w, p);
+		}
+	}
+
+	// add the argument to the parameter array
+	inline void add(const unsigned long long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
 	inline void add(const long long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
 	inline void add(const char x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
 	inline void add(const double x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
 	inline void add(const char *x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
 	inline void add(const bool x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
-	inline void add(const std::string &x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x.c_str(), w, p); }
+	inline void add(const std::string &x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(str_ref(x), w, p); }
+	inline void add(const str_ref &x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(x, w, p); }
+	#ifdef PRESS_HAS_STRING_VIEW
+	inline void add(const std::string_view &x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(str_ref(x), w, p); }
+	#endif
+
+	// forward to another add overload
+	inline void add(const unsigned long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
+	inline void add(const unsigned x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
+	inline void add(const unsigned short x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
+	inline void add(const unsigned char x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
+	inline void add(const long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((long long)x, array, index, w, p); }
+	inline void add(const int x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((long long)x, array, index, w, p); }
+	inline void add(const short x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((long long)x, array, index, w, p); }
+	inline void add(const float x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init((double)x, w, p); }
+
+	// byte buffers
+	inline void hexdump_trampoline(Writer &output, const void *object, const Format &format)
+	{
+		const hexdump_spec &dump = *(const hexdump_spec*)object;
+		Converter::bytes(output, dump.data, dump.length, dump.separator, format, -1, -1);
+	}
+
+	inline void add(const hexdump_spec &x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(&hexdump_trampoline, (const void*)&x, w, p); }
+
+	// ranges
+	template <typename It> void join_trampoline(Writer &output, const void *object, const Format &format);
+	template <typename It> inline void add(const join_spec<It> &x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init(&join_trampoline<It>, (const void*)&x, w, p); }
+
+	// runtime width and precision
+	template <typename T> inline void add(const press::width_spec<T> &pw, Parameter *array, int &index) { add(pw.arg, array, index, pw.value, -1); }
+	template <typename T> inline void add(const press::precision_spec<T> &pp, Parameter *array, int &index) { add(pp.arg, array, index, -1, pp.value); }
+	template <typename T> inline void add(const press::width_precision_spec<T> &pwp, Parameter *array, int &index) { add(pwp.arg, array, index, pwp.w, pwp.p); }
+
+	#ifdef PRESS_STATIC_DISPATCH
+	// dummy primary template
+	template <typename T> inline void convert_ptr(const typename std::enable_if<!is_pointer<T>::value, T>::type&, Writer&, const Format&, signed char) {}
+
+	// catch pointers
+	template <typename T> inline void convert_ptr(const typename std::enable_if<is_pointer<T>::value, T>::type& vp, Writer &output, const Format &format, signed char w)
+	{
+		Converter::pointer(output, (const void*)vp, format, w);
+	}
+
+	template <typename T> inline void convert_custom(const typename std::enable_if<has_format_to<T>::value, T>::type &x, Writer &output, const Format &format, signed char w, signed char p)
+	{
+		Converter::formatter(output, &format_to_trampoline<T>, (const void*)&x, format, w, p);
+	}
+
+	template <typename T> inline void convert_custom(const typename std::enable_if<!has_format_to<T>::value, T>::type &x, Writer &output, const Format &format, signed char w, signed char)
+	{
+	#ifdef PRESS_STATS
+		count(global_stats().allocations);
+	#endif
+		Converter::custom(output, press::to_string(x), format, w);
+	}
+
+	template <typename T> inline void convert_arg(const T &x, Writer &output, const Format &format, signed char w = -1, signed char p = -1)
+	{
+		if(is_pointer<T>::value)
+		{
+			convert_ptr<T>(x, output, format, w);
+		}
+		else
+		{
+			convert_custom<T>(x, output, format, w, p);
+		}
+	}
+
+	// convert the argument directly, mirrors the add overloads
+	inline void convert_arg(const unsigned long long x, Writer &output, const Format &format, signed char w = -1, signed char = -1) { Converter::integer<unsigned long long>(output, x, format, w); }
+	inline void convert_arg(const long long x, Writer &output, const Format &format, signed char w = -1, signed char = -1) { Converter::integer<long long>(output, x, format, w); }
+	inline void convert_arg(const char x, Writer &output, const Format &format, signed char w = -1, signed char = -1) { Converter::character(output, x, format, w); }
+	inline void convert_arg(const double x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::float64(output, x, format, w, p); }
+	inline void convert_arg(const char *x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::string(output, x, format, w, p); }
+	inline void convert_arg(const bool x, Writer &output, const Format &format, signed char w = -1, signed char = -1) { Converter::boolean(output, x, format, w); }
+	inline void convert_arg(const std::string &x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::string(output, str_ref(x), format, w, p); }
+	inline void convert_arg(const str_ref &x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::string(output, x, format, w, p); }
+	#ifdef PRESS_HAS_STRING_VIEW
+	inline void convert_arg(const std::string_view &x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::string(output, str_ref(x), format, w, p); }
+	#endif
+
+	// forward to another convert_arg overload
+	inline void convert_arg(const unsigned long x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((unsigned long long)x, output, format, w, p); }
+	inline void convert_arg(const unsigned x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((unsigned long long)x, output, format, w, p); }
+	inline void convert_arg(const unsigned short x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((unsigned long long)x, output, format, w, p); }
+	inline void convert_arg(const unsigned char x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((unsigned long long)x, output, format, w, p); }
+	inline void convert_arg(const long x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((long long)x, output, format, w, p); }
+	inline void convert_arg(const int x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((long long)x, output, format, w, p); }
+	inline void convert_arg(const short x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((long long)x, output, format, w, p); }
+	inline void convert_arg(const float x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { convert_arg((double)x, output, format, w, p); }
+
+	// byte buffers
+	inline void convert_arg(const hexdump_spec &x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::bytes(output, x.data, x.length, x.separator, format, w, p); }
+
+	// ranges
+	template <typename It> inline void convert_arg(const join_spec<It> &x, Writer &output, const Format &format, signed char w = -1, signed char p = -1) { Converter::formatter(output, &join_trampoline<It>, (const void*)&x, format, w, p); }
+
+	// runtime width and precision
+	template <typename T> inline void convert_arg(const press::width_spec<T> &pw, Writer &output, const Format &format) { convert_arg(pw.arg, output, format, pw.value, -1); }
+	template <typename T> inline void convert_arg(const press::precision_spec<T> &pp, Writer &output, const Format &format) { convert_arg(pp.arg, output, format, -1, pp.value); }
+	template <typename T> inline void convert_arg(const press::width_precision_spec<T> &pwp, Writer &output, const Format &format) { convert_arg(pwp.arg, output, format, pwp.w, pwp.p); }
+
+	// argument source for the printers: references to the arguments themselves, so each one is converted
+	// by a direct call to its converter instead of a switch on a Parameter's type tag
+	template <typename... Ts> struct typed_args
+	{
+		int size() const { return 0; }
+		void convert(const int, Writer&, const Format&) const {}
+	};
+
+	template <typename T, typename... Ts> struct typed_args<T, Ts...> : typed_args<Ts...>
+	{
+		typed_args(const T &t, const Ts&... ts) : typed_args<Ts...>(ts...), arg(t) {}
+
+		int size() const { return 1 + sizeof...(Ts); }
+		void convert(const int index, Writer &output, const Format &format) const
+		{
+			if(index == 0)
+				convert_arg(arg, output, format);
+			else
+				typed_args<Ts...>::convert(index - 1, output, format);
+		}
+
+		const T &arg;
+	};
+	#endif
+
+	// convert one element of a range, arrays of numbers go straight to their converter
+	template <typename T> inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value && !std::is_same<T, char>::value>::type convert_element(Writer &output, const T x, const Format &format)
+	{
+		Converter::integer<long long>(output, x, format, -1);
+	}
+
+	template <typename T> inline typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type convert_element(Writer &output, const T x, const Format &format)
+	{
+		Converter::integer<unsigned long long>(output, x, format, -1);
+	}
+
+	template <typename T> inline typename std::enable_if<std::is_floating_point<T>::value>::type convert_element(Writer &output, const T x, const Format &format)
+	{
+		Converter::float64(output, x, format, -1, -1);
+	}
+
+	template <typename T> inline typename std::enable_if<!std::is_arithmetic<T>::value || std::is_same<T, bool>::value || std::is_same<T, char>::value>::type convert_element(Writer &output, const T &x, const Format &format)
+	{
+	#ifdef PRESS_STATIC_DISPATCH
+		convert_arg(x, output, format);
+	#else
+		Parameter param;
+		int index = 0;
+		add(x, &param, index);
+		param.convert(output, format);
+	#endif
+	}
+
+	template <typename It> void join_trampoline(Writer &output, const void *object, const Format &format)
+	{
+		const join_spec<It> &join = *(const join_spec<It>*)object;
+		for(It it = join.first; it != join.last; ++it)
+		{
+			if(it != join.first)
+				output.write(join.separator, join.separator_length);
+
+			convert_element(output, *it, format);
+		}
+	}
+
+	// interfaces
+
+	// a guess at the output size, so that formatting into a std::string rarely needs to grow it
+	inline int estimate_size(const format_string &fmt, const int pack_size)
+	{
+		return (fmt.compiled != NULL ? fmt.compiled->fmt_len : (int)strlen(fmt.fmt)) + pack_size * 16;
+	}
+
+	template <typename Args> inline void dispatch(Writer &output, const format_string &fmt, const Args &args)
+	{
+		if(fmt.compiled != NULL)
+		{
+			impl::printer(*fmt.compiled, args, output);
+			return;
+		}
+
+	#ifdef PRESS_FORMAT_CACHE
+		const format_cache::pin cached(fmt.fmt);
+		if(cached.get() != NULL)
+		{
+			impl::printer(*cached.get(), args, output);
+			return;
+		}
+	#endif
+
+		impl::printer(fmt.fmt, args, output);
+	}
+
+	// the type-erased printers, instantiated once here rather than in every caller's translation unit
+	PRESS_CORE void dispatch(Writer &output, const format_string &fmt, const erased_args &args);
+
+	#ifdef PRESS_CORE_DEFINITIONS
+	PRESS_CORE void dispatch(Writer &output, const format_string &fmt, const erased_args &args)
+	{
+		dispatch<erased_args>(output, fmt, args);
+	}
+	#endif
+
+	// fill storage with a Parameter for each of ts
+	template <typename... Ts> inline void add_all(Parameter *storage, const Ts&... ts)
+	{
+		#if defined (__GNUC__)
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wunused-variable"
+		#endif
+
+		#if defined (__GNUC__)
+		#pragma GCC diagnostic push
+		#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+		#endif
 
-	// forward to another add overload
-	inline void add(const unsigned long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
-	inline void add(const unsigned x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
-	inline void add(const unsigned short x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
-	inline void add(const unsigned char x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((unsigned long long)x, array, index, w, p); }
-	inline void add(const long x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((long long)x, array, index, w, p); }
-	inline void add(const int x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((long long)x, array, index, w, p); }
-	inline void add(const short x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { add((long long)x, array, index, w, p); }
-	inline void add(const float x, Parameter *array, int &index, signed char w = -1, signed char p = -1) { array[index++].init((double)x, w, p); }
+		// with no parameters, storage isn't used
+		(void)storage;
+
+		int index = 0;
+		const char dummy[sizeof...(Ts)] = { (add(ts, storage, index), (char)1)... };
+
+		#if defined (__GNUC__)
+		#pragma GCC diagnostic pop
+		#endif
+
+		#if defined (__GNUC__)
+		#pragma GCC diagnostic pop
+		#endif
+	}
+
+	#ifdef PRESS_STATIC_DISPATCH
+	template <typename... Ts> inline int write(PrintTarget target, FILE *fp, int fd, std::string *stdstring, char *userbuffer, int userbuffer_size, bool newline, const format_string &fmt, const Ts&... ts)
+	{
+		Writer output(target, fp, fd, stdstring, userbuffer, target == PrintTarget::STDSTRING ? estimate_size(fmt, sizeof...(Ts)) : userbuffer_size);
+		dispatch(output, fmt, typed_args<Ts...>(ts...));
+		if(newline)
+			output.write("\n", 1);
+
+		return output.total();
+	}
+	#else
+	template <typename... Ts> inline int write(PrintTarget target, FILE *fp, int fd, std::string *stdstring, char *userbuffer, int userbuffer_size, bool newline, const format_string &fmt, const Ts&... ts)
+	{
+		// exactly sized, so no call allocates regardless of how many parameters it has
+		Parameter storage[sizeof...(Ts) > 0 ? sizeof...(Ts) : 1];
+		add_all(storage, ts...);
+
+		Writer output(target, fp, fd, stdstring, userbuffer, target == PrintTarget::STDSTRING ? estimate_size(fmt, sizeof...(Ts)) : userbuffer_size);
+		dispatch(output, fmt, erased_args(storage, sizeof...(Ts)));
+		if(newline)
+			output.write("\n", 1);
+
+		return output.total();
+	}
+	#endif
+
+	// format into a Writer made by the caller, see press::format_to
+	#ifdef PRESS_STATIC_DISPATCH
+	template <typename... Ts> inline int write_to(Writer &output, const format_string &fmt, const Ts&... ts)
+	{
+		dispatch(output, fmt, typed_args<Ts...>(ts...));
+		return output.total();
+	}
+	#else
+	template <typename... Ts> inline int write_to(Writer &output, const format_string &fmt, const Ts&... ts)
+	{
+		Parameter storage[sizeof...(Ts) > 0 ? sizeof...(Ts) : 1];
+		add_all(storage, ts...);
+		dispatch(output, fmt, erased_args(storage, sizeof...(Ts)));
+		return output.total();
+	}
+	#endif
+
+	// tables: the columns are random access ranges, row i is formatted from the i'th element of each column
+	template <typename C> struct column_element
+	{
+		typedef typename std::decay<decltype(std::begin(std::declval<const C&>())[0])>::type type;
+	};
+
+	template <typename C> inline size_t row_count(const C &column)
+	{
+		return std::end(column) - std::begin(column);
+	}
+
+	template <typename C, typename... Cs> inline size_t row_count(const C &column, const Cs&... columns)
+	{
+		return std::min(row_count(column), row_count(columns...));
+	}
+
+	template <typename F, typename... Cs> inline void write_rows(Writer &output, const F &fmt, const size_t rows, const Cs&... columns)
+	{
+		for(size_t row = 0; row < rows; ++row)
+		{
+		#ifdef PRESS_STATIC_DISPATCH
+			printer(fmt, typed_args<typename column_element<Cs>::type...>(std::begin(columns)[row]...), output);
+		#else
+			Parameter storage[sizeof...(Cs)];
+			add_all(storage, std::begin(columns)[row]...);
+			printer(fmt, erased_args(storage, sizeof...(Cs)), output);
+		#endif
+			output.write("\n", 1);
+		}
+	}
+
+	template <typename... Cs> inline int write_table(Writer &output, const format_string &fmt, const Cs&... columns)
+	{
+		const size_t rows = row_count(columns...);
+		if(fmt.compiled != NULL)
+			write_rows(output, *fmt.compiled, rows, columns...);
+		else
+		{
+			// parse the format once for all of the rows
+			const compiled_format_storage<64> compiled(fmt.fmt);
+			if(compiled.compiled())
+				write_rows(output, (const compiled_format&)compiled, rows, columns...);
+			else
+				write_rows(output, fmt.fmt, rows, columns...);
+		}
+
+		return output.total();
+	}
+	}
+
+	// print, fprint and bprint return the number of bytes produced. like snprintf, bprint returns the length the output would have
+	// had if userbuffer was large enough
+
+	template <typename... Ts> int print(const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::FILE_P, stdout, -1, NULL, NULL, 0, false, fmt, ts...);
+	}
+
+	template <typename... Ts> int println(const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::FILE_P, stdout, -1, NULL, NULL, 0, true, fmt, ts...);
+	}
+
+	template <typename... Ts> int fprint(FILE *fp, const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::FILE_P, fp, -1, NULL, NULL, 0, false, fmt, ts...);
+	}
+
+	template <typename... Ts> int fprintln(FILE *fp, const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::FILE_P, fp, -1, NULL, NULL, 0, true, fmt, ts...);
+	}
+
+	template <typename... Ts> int bprint(char *userbuffer, int userbuffer_size, const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::BUFFER, NULL, -1, NULL, userbuffer, userbuffer_size, false, fmt, ts...);
+	}
+
+	template <typename... Ts> int bprintln(char *userbuffer, int userbuffer_size, const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::BUFFER, NULL, -1, NULL, userbuffer, userbuffer_size, true, fmt, ts...);
+	}
+
+	// print a table, one line per row, where each parameter is a column (a random access container or array) and row i is printed
+	// with the i'th element of each column. the format is parsed once, and the whole table goes through one buffer
+	// e.g. press::print_rows("{-10} {8.2}", names, prices)
+	template <typename C, typename... Cs> int print_rows(const format_string &fmt, const C &column, const Cs&... columns)
+	{
+		Writer output(PrintTarget::FILE_P, stdout, -1, NULL, NULL, 0);
+		return impl::write_table(output, fmt, column, columns...);
+	}
+
+	template <typename C, typename... Cs> int fprint_rows(FILE *fp, const format_string &fmt, const C &column, const Cs&... columns)
+	{
+		Writer output(PrintTarget::FILE_P, fp, -1, NULL, NULL, 0);
+		return impl::write_table(output, fmt, column, columns...);
+	}
+
+	template <typename C, typename... Cs> std::string sprint_rows(const format_string &fmt, const C &column, const Cs&... columns)
+	{
+		std::string table;
+		{
+			// clamped like write_shard's chunks, so the hint for a large table neither wraps nor overflows when the string grows
+			const size_t estimate = impl::row_count(column, columns...) * (size_t)impl::estimate_size(fmt, 1 + sizeof...(Cs));
+			Writer output(PrintTarget::STDSTRING, NULL, -1, &table, NULL, (int)std::min(estimate, (size_t)INT_MAX / 2));
+			impl::write_table(output, fmt, column, columns...);
+		}
+
+		return table;
+	}
+
+	#ifdef PRESS_HAS_FD
+	// write straight to a file descriptor (socket, pipe, ...) with write/writev, skipping stdio. each call is written with as few
+	// syscalls as possible, usually one
+	template <typename... Ts> int dprint(int fd, const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::FD, NULL, fd, NULL, NULL, 0, false, fmt, ts...);
+	}
+
+	template <typename... Ts> int dprintln(int fd, const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::FD, NULL, fd, NULL, NULL, 0, true, fmt, ts...);
+	}
+	#endif
+
+	// the number of bytes the output would take, not counting a null terminator
+	template <typename... Ts> int formatted_size(const format_string &fmt, const Ts&... ts)
+	{
+		return impl::write(PrintTarget::COUNT, NULL, -1, NULL, NULL, 0, false, fmt, ts...);
+	}
+
+	template <typename... Ts> std::string sprint(const format_string &fmt, const Ts&... ts)
+	{
+		std::string output;
+		impl::write(PrintTarget::STDSTRING, NULL, -1, &output, NULL, 0, false, fmt, ts...);
+
+		return output;
+	}
+
+	template <typename... Ts> std::string sprintln(const format_string &fmt, const Ts&... ts)
+	{
+		std::string output;
+		impl::write(PrintTarget::STDSTRING, NULL, -1, &output, NULL, 0, true, fmt, ts...);
+
+		return output;
+	}
+
+	// format into a caller owned string, replacing its contents but reusing its storage
+	template <typename... Ts> void sprint_into(std::string &output, const format_string &fmt, const Ts&... ts)
+	{
+		output.clear();
+		impl::write(PrintTarget::STDSTRING, NULL, -1, &output, NULL, 0, false, fmt, ts...);
+	}
+
+	template <typename... Ts> void sprintln_into(std::string &output, const format_string &fmt, const Ts&... ts)
+	{
+		output.clear();
+		impl::write(PrintTarget::STDSTRING, NULL, -1, &output, NULL, 0, true, fmt, ts...);
+	}
+
+	namespace impl{
+	// sinks that take their output in pieces, like a ring buffer or a compressed stream
+	template <typename S> struct has_append
+	{
+		template <typename U> static auto test(int) -> decltype(std::declval<U&>().append(std::declval<const char*>(), std::declval<size_t>()), std::true_type());
+		template <typename U> static std::false_type test(...);
+
+		constexpr static bool value = decltype(test<S>(0))::value;
+	};
+
+	// containers that are resized and written into directly
+	template <typename S> struct is_contiguous_sink : std::false_type {};
+	template <typename A> struct is_contiguous_sink<std::vector<char, A>> : std::true_type {};
+	template <typename T, typename A> struct is_contiguous_sink<std::basic_string<char, T, A>> : std::true_type {};
+
+	// anything else is an output iterator of char
+	template <typename S> struct is_iterator_sink
+	{
+		constexpr static bool value = !is_contiguous_sink<S>::value && !has_append<S>::value && !std::is_same<S, Writer>::value;
+	};
+
+	template <typename S> void append_to_sink(void *sink, const char *data, size_t count)
+	{
+		((S*)sink)->append(data, count);
+	}
+
+	template <typename It> void copy_to_iterator(void *sink, const char *data, size_t count)
+	{
+		It &out = *(It*)sink;
+		out = std::copy(data, data + count, out);
+	}
+	}
+
+	// format into a container or a user's sink, returning the number of bytes produced. std::string and std::vector<char> are
+	// appended to in place, anything else with an append(const char*, size_t) member gets the output in pieces of up to
+	// Writer::WRITER_BUFFER_SIZE bytes
+	template <typename S, typename... Ts> typename std::enable_if<impl::is_contiguous_sink<S>::value, int>::type format_to(S &sink, const format_string &fmt, const Ts&... ts)
+	{
+		Writer output(sink, impl::estimate_size(fmt, sizeof...(Ts)));
+		return impl::write_to(output, fmt, ts...);
+	}
+
+	template <typename S, typename... Ts> typename std::enable_if<!impl::is_contiguous_sink<S>::value && impl::has_append<S>::value, int>::type format_to(S &sink, const format_string &fmt, const Ts&... ts)
+	{
+		Writer output((void*)&sink, &impl::append_to_sink<S>);
+		return impl::write_to(output, fmt, ts...);
+	}
+
+	// format through an output iterator of char (e.g. std::back_inserter(deque)), returning the iterator past the output
+	template <typename It, typename... Ts> typename std::enable_if<impl::is_iterator_sink<It>::value, It>::type format_to(It out, const format_string &fmt, const Ts&... ts)
+	{
+		{
+			Writer output((void*)&out, &impl::copy_to_iterator<It>);
+			impl::write_to(output, fmt, ts...);
+		}
+
+		return out;
+	}
+
+	// a list of parameters built at runtime, for press::vprint and friends. the first INLINE_COUNT parameters are stored in the
+	// object itself, and the list can be cleared and refilled without allocating again. like the parameters of a print call,
+	// strings and format_to types are referenced, not copied, so they must outlive the calls the list is printed with
+	namespace impl{
+	// wrappers that refer to their own storage, and are usually temporaries, so dynamic_args keeps a copy of them
+	template <typename T> struct is_kept : std::false_type {};
+	template <typename It> struct is_kept<join_spec<It>> : std::true_type {};
+	template <> struct is_kept<hexdump_spec> : std::true_type {};
+
+	struct kept_arg
+	{
+		virtual ~kept_arg() {}
+	};
+
+	template <typename T> struct kept_value : kept_arg
+	{
+		explicit kept_value(const T &x) : value(x) {}
+		const T value;
+	};
+	}
+
+	class dynamic_args
+	{
+	public:
+		static constexpr int INLINE_COUNT = 16;
+
+		dynamic_args() : m_params(m_inline), m_size(0), m_capacity(INLINE_COUNT) {}
+		dynamic_args(const dynamic_args&) = delete;
+		dynamic_args &operator=(const dynamic_args&) = delete;
+
+		// anything a print call accepts, including press::set_width and friends. strings (and the containers and buffers
+		// behind press::join and press::hexdump) are referenced, the press::join and press::hexdump wrappers themselves are copied
+		template <typename T> typename std::enable_if<!impl::is_kept<T>::value>::type push_back(const T &x)
+		{
+			if(m_size == m_capacity)
+				grow();
+
+			impl::add(x, m_params, m_size);
+		}
+
+		template <typename T> typename std::enable_if<impl::is_kept<T>::value>::type push_back(const T &x) { keep(x, -1, -1); }
+		template <typename T> typename std::enable_if<impl::is_kept<T>::value>::type push_back(const width_spec<T> &x) { keep(x.arg, x.value, -1); }
+		template <typename T> typename std::enable_if<impl::is_kept<T>::value>::type push_back(const precision_spec<T> &x) { keep(x.arg, -1, x.value); }
+		template <typename T> typename std::enable_if<impl::is_kept<T>::value>::type push_back(const width_precision_spec<T> &x) { keep(x.arg, x.w, x.p); }
+
+		void clear()
+		{
+			for(int i = 0; i < m_size; ++i)
+				m_params[i] = Parameter();
+
+			m_size = 0;
+			m_kept.clear();
+		}
+
+		int size() const
+		{
+			return m_size;
+		}
+
+		const Parameter *data() const
+		{
+			return m_params;
+		}
+
+	private:
+		void grow()
+		{
+			std::unique_ptr<Parameter[]> bigger(new Parameter[m_capacity * 2]);
+			for(int i = 0; i < m_size; ++i)
+				bigger[i] = std::move(m_params[i]);
+
+			m_heap = std::move(bigger);
+			m_params = m_heap.get();
+			m_capacity *= 2;
+		}
+
+		template <typename T> void keep(const T &x, const signed char w, const signed char p)
+		{
+			if(m_size == m_capacity)
+				grow();
+
+			impl::kept_value<T> *const copy = new impl::kept_value<T>(x);
+			m_kept.emplace_back(copy);
+			impl::add(copy->value, m_params, m_size, w, p);
+		}
+
+		Parameter m_inline[INLINE_COUNT];
+		std::unique_ptr<Parameter[]> m_heap; // once there are more than INLINE_COUNT parameters
+		std::vector<std::unique_ptr<impl::kept_arg>> m_kept; // copies of the press::join and press::hexdump parameters
+		Parameter *m_params;
+		int m_size;
+		int m_capacity;
+	};
+
+	namespace impl{
+	inline int vwrite(PrintTarget target, FILE *fp, std::string *stdstring, char *userbuffer, int userbuffer_size, bool newline, const format_string &fmt, const dynamic_args &args)
+	{
+		Writer output(target, fp, -1, stdstring, userbuffer, target == PrintTarget::STDSTRING ? estimate_size(fmt, args.size()) : userbuffer_size);
+		dispatch(output, fmt, erased_args(args.data(), args.size()));
+		if(newline)
+			output.write("\n", 1);
+
+		return output.total();
+	}
+	}
+
+	// the print functions with a dynamic_args list in place of the parameter pack
+	inline int vprint(const format_string &fmt, const dynamic_args &args)
+	{
+		return impl::vwrite(PrintTarget::FILE_P, stdout, NULL, NULL, 0, false, fmt, args);
+	}
+
+	inline int vprintln(const format_string &fmt, const dynamic_args &args)
+	{
+		return impl::vwrite(PrintTarget::FILE_P, stdout, NULL, NULL, 0, true, fmt, args);
+	}
+
+	inline int vfprint(FILE *fp, const format_string &fmt, const dynamic_args &args)
+	{
+		return impl::vwrite(PrintTarget::FILE_P, fp, NULL, NULL, 0, false, fmt, args);
+	}
+
+	inline int vfprintln(FILE *fp, const format_string &fmt, const dynamic_args &args)
+	{
+		return impl::vwrite(PrintTarget::FILE_P, fp, NULL, NULL, 0, true, fmt, args);
+	}
+
+	inline int vbprint(char *userbuffer, int userbuffer_size, const format_string &fmt, const dynamic_args &args)
+	{
+		return impl::vwrite(PrintTarget::BUFFER, NULL, NULL, userbuffer, userbuffer_size, false, fmt, args);
+	}
+
+	inline std::string vsprint(const format_string &fmt, const dynamic_args &args)
+	{
+		std::string output;
+		impl::vwrite(PrintTarget::STDSTRING, NULL, &output, NULL, 0, false, fmt, args);
+
+		return output;
+	}
+
+	#ifdef PRESS_PARALLEL
+	namespace impl{
+	template <size_t... Is> struct index_list {};
+	template <size_t N, size_t... Is> struct make_index_list : make_index_list<N - 1, N - 1, Is...> {};
+	template <size_t... Is> struct make_index_list<0, Is...> { typedef index_list<Is...> type; };
+
+	// a record is a std::tuple of parameters, or a single parameter
+	template <typename F, typename... Ts, size_t... Is> inline void write_tuple(Writer &output, const F &fmt, const std::tuple<Ts...> &record, index_list<Is...>)
+	{
+	#ifdef PRESS_STATIC_DISPATCH
+		printer(fmt, typed_args<Ts...>(std::get<Is>(record)...), output);
+	#else
+		Parameter storage[sizeof...(Ts) > 0 ? sizeof...(Ts) : 1];
+		add_all(storage, std::get<Is>(record)...);
+		printer(fmt, erased_args(storage, sizeof...(Ts)), output);
+	#endif
+	}
+
+	template <typename F, typename... Ts> inline void write_record(Writer &output, const F &fmt, const std::tuple<Ts...> &record)
+	{
+		write_tuple(output, fmt, record, typename make_index_list<sizeof...(Ts)>::type());
+	}
+
+	template <typename F, typename T> inline void write_record(Writer &output, const F &fmt, const T &record)
+	{
+		write_tuple(output, fmt, std::tuple<const T&>(record), index_list<0>());
+	}
+
+	// one thread's share of a round, formatted into a chunk that keeps its capacity from round to round
+	template <typename F, typename It> void write_shard(std::string &chunk, const F &fmt, It first, const It last)
+	{
+		chunk.clear();
+		Writer output(PrintTarget::STDSTRING, NULL, -1, &chunk, NULL, (int)std::min(chunk.capacity(), (size_t)INT_MAX / 2));
+		for(; first != last; ++first)
+			write_record(output, fmt, *first);
+	}
+
+	// records are formatted in rounds of up to RECORDS_PER_SHARD per thread. while the threads format a round, the calling
+	// thread hands the chunks of the previous one to emit in order, so the output is never held in memory all at once
+	static constexpr size_t RECORDS_PER_SHARD = 16384;
+
+	template <typename F, typename R, typename E> size_t parallel_rounds(const F &fmt, const R &records, const int thread_count, const E &emit)
+	{
+		const size_t count = std::end(records) - std::begin(records);
+		const unsigned hardware = std::thread::hardware_concurrency();
+		const size_t threads = thread_count > 0 ? thread_count : (hardware > 0 ? hardware : 1);
+
+		std::vector<std::string> chunks[2] = {std::vector<std::string>(threads), std::vector<std::string>(threads)};
+		size_t pending = 0; // chunks of the previous round waiting for emit
+		size_t total = 0;
+		int current = 0;
+		for(size_t done = 0; done < count || pending > 0; current ^= 1)
+		{
+			const size_t remaining = count - done;
+			const size_t shard = std::min(RECORDS_PER_SHARD, (remaining + threads - 1) / threads);
+			const size_t shards = shard == 0 ? 0 : (remaining + shard - 1) / shard;
+			const size_t round = std::min(remaining, shard * threads);
+
+			// a single shard isn't worth a thread
+			std::vector<std::thread> workers;
+			if(shards == 1)
+				write_shard(chunks[current][0], fmt, std::begin(records) + done, std::begin(records) + done + round);
+			else
+			{
+				for(size_t t = 0; t < shards && t * shard < round; ++t)
+				{
+					const size_t first = done + t * shard;
+					const size_t last = std::min(first + shard, done + round);
+					workers.emplace_back([&, t, first, last]() { write_shard(chunks[current][t], fmt, std::begin(records) + first, std::begin(records) + last); });
+				}
+			}
+
+			for(size_t t = 0; t < pending; ++t)
+			{
+				emit(chunks[current ^ 1][t]);
+				total += chunks[current ^ 1][t].size();
+			}
+
+			for(size_t t = 0; t < workers.size(); ++t)
+				workers[t].join();
+
+			pending = shards == 1 ? 1 : workers.size();
+			done += round;
+		}
+
+		return total;
+	}
+
+	template <typename R, typename E> size_t parallel_write(const format_string &fmt, const R &records, const int thread_count, const E &emit)
+	{
+		if(fmt.compiled != NULL)
+			return parallel_rounds(*fmt.compiled, records, thread_count, emit);
+
+		// parse the format once for every thread
+		const compiled_format_storage<64> compiled(fmt.fmt);
+		if(compiled.compiled())
+			return parallel_rounds((const compiled_format&)compiled, records, thread_count, emit);
+
+		return parallel_rounds(fmt.fmt, records, thread_count, emit);
+	}
+	}
+
+	// format every record of a random access range with fmt, using thread_count threads (0 for one per core), and write the
+	// output in order. each record is a std::tuple of parameters, or a single parameter. no newlines are added, so end fmt with
+	// "\n" for one line per record. returns the number of bytes written
+	// e.g. press::parallel_format(fp, prcompile("{},{},{.2}\n"), rows) where rows is a std::vector<std::tuple<int, std::string, double>>
+	template <typename R> size_t parallel_format(FILE *fp, const format_string &fmt, const R &records, const int thread_count = 0)
+	{
+		return impl::parallel_write(fmt, records, thread_count, [fp](const std::string &chunk) { fwrite(chunk.data(), 1, chunk.size(), fp); });
+	}
+
+	// appends to output
+	template <typename R> size_t parallel_format(std::string &output, const format_string &fmt, const R &records, const int thread_count = 0)
+	{
+		return impl::parallel_write(fmt, records, thread_count, [&output](const std::string &chunk) { output.append(chunk); });
+	}
+
+	#ifdef PRESS_HAS_FD
+	template <typename R> size_t parallel_format(int fd, const format_string &fmt, const R &records, const int thread_count = 0)
+	{
+		return impl::parallel_write(fmt, records, thread_count, [fd](const std::string &chunk)
+		{
+			const char *data = chunk.data();
+			size_t remaining = chunk.size();
+			while(remaining > 0)
+			{
+				const ssize_t written = ::write(fd, data, remaining);
+				if(written < 0)
+				{
+					if(errno == EINTR)
+						continue;
 
-	// runtime width and precision
-	template <typename T> inline void add(const press::width_spec<T> &pw, Parameter *array, int &index) { add(pw.arg, array, index, pw.value, -1); }
-	template <typename T> inline void add(const press::precision_spec<T> &pp, Parameter *array, int &index) { add(pp.arg, array, index, -1, pp.value); }
-	template <typename T> inline void add(const press::width_precision_spec<T> &pwp, Parameter *array, int &index) { add(pwp.arg, array, index, pwp.w, pwp.p); }
+					// like a failed fwrite, the output is lost
+					break;
+				}
 
-	// interfaces
+				data += written;
+				remaining -= written;
+			}
+		});
+	}
+	#endif
+	#endif
 
-	const int DEFAULT_AUTO_SIZE = 10;
-	template <typename... Ts> inline void write(PrintTarget target, FILE *fp, std::string *stdstring, char *userbuffer, int userbuffer_size, const char *fmt, const Ts&... ts)
+	// collects the output of many print calls in one large buffer, and writes it out in big chunks. output is written when
+	// the buffer reaches its threshold (or at the end of every line with flush_policy::LINE), when flush() is called, and
+	// when the stream is destroyed. a buffered_stream is not thread safe, use press::thread_stream() for one per thread
+	class buffered_stream
 	{
-		Parameter *storage;
-		std::unique_ptr<Parameter[]> dynamic;
-		Parameter automatic[DEFAULT_AUTO_SIZE];
-		if(sizeof...(Ts) > DEFAULT_AUTO_SIZE)
+	public:
+		enum class flush_policy
+		{
+			THRESHOLD, // flush when the buffered output reaches the threshold
+			LINE // also flush after any call that printed a newline
+		};
+
+		static constexpr size_t DEFAULT_THRESHOLD = 64 * 1024;
+
+		buffered_stream(FILE *fp, size_t threshold = DEFAULT_THRESHOLD, flush_policy policy = flush_policy::THRESHOLD)
+			: m_fp(fp)
+			, m_fd(-1)
+			, m_threshold(threshold)
+			, m_policy(policy)
 		{
-			dynamic.reset(new Parameter[sizeof...(Ts)]);
-			storage = dynamic.get();
+			m_buffer.reserve(threshold + Writer::WRITER_BUFFER_SIZE);
 		}
-		else
+
+	#ifdef PRESS_HAS_FD
+		buffered_stream(int fd, size_t threshold = DEFAULT_THRESHOLD, flush_policy policy = flush_policy::THRESHOLD)
+			: m_fp(NULL)
+			, m_fd(fd)
+			, m_threshold(threshold)
+			, m_policy(policy)
 		{
-			storage = automatic;
+			m_buffer.reserve(threshold + Writer::WRITER_BUFFER_SIZE);
 		}
+	#endif
 
-		#if defined (__GNUC__)
-		#pragma GCC diagnostic push
-		#pragma GCC diagnostic ignored "-Wunused-variable"
-		#endif
+		buffered_stream(const buffered_stream&) = delete;
+		buffered_stream &operator=(const buffered_stream&) = delete;
 
-		#if defined (__GNUC__)
-		#pragma GCC diagnostic push
-		#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
-		#endif
+		~buffered_stream()
+		{
+			flush();
+		}
 
-		int index = 0;
-		const char dummy[sizeof...(Ts)] = { (add(ts, storage, index), (char)1)... };
+		template <typename... Ts> int print(const format_string &fmt, const Ts&... ts)
+		{
+			return append(false, fmt, ts...);
+		}
 
-		#if defined (__GNUC__)
-		#pragma GCC diagnostic pop
-		#endif
+		template <typename... Ts> int println(const format_string &fmt, const Ts&... ts)
+		{
+			return append(true, fmt, ts...);
+		}
 
-		#if defined (__GNUC__)
-		#pragma GCC diagnostic pop
+		void flush()
+		{
+			if(m_buffer.empty())
+				return;
+
+			if(m_fp != NULL)
+				fwrite(m_buffer.data(), 1, m_buffer.size(), m_fp);
+		#ifdef PRESS_HAS_FD
+			else
+			{
+				Writer output(PrintTarget::FD, NULL, m_fd, NULL, NULL, 0);
+				output.write_ref(m_buffer.data(), m_buffer.size());
+			}
 		#endif
 
-		impl::printer(fmt, storage, sizeof...(Ts), target, fp, stdstring, userbuffer, userbuffer_size);
-	}}
+			m_buffer.clear();
+		}
+
+		void set_threshold(size_t threshold)
+		{
+			m_threshold = threshold;
+			m_buffer.reserve(threshold + Writer::WRITER_BUFFER_SIZE);
+			if(m_buffer.size() >= m_threshold)
+				flush();
+		}
+
+		void set_policy(flush_policy policy)
+		{
+			m_policy = policy;
+		}
+
+		FILE *file() const
+		{
+			return m_fp;
+		}
+
+		int fd() const
+		{
+			return m_fd;
+		}
+
+	private:
+		template <typename... Ts> int append(bool newline, const format_string &fmt, const Ts&... ts)
+		{
+			const size_t start = m_buffer.size();
+			const int written = impl::write(PrintTarget::STDSTRING, NULL, -1, &m_buffer, NULL, 0, newline, fmt, ts...);
+
+			if(m_buffer.size() >= m_threshold || (m_policy == flush_policy::LINE && (newline || memchr(m_buffer.data() + start, '\n', written) != NULL)))
+				flush();
+
+			return written;
+		}
+
+		FILE *const m_fp;
+		const int m_fd;
+		size_t m_threshold;
+		flush_policy m_policy;
+		std::string m_buffer;
+	};
+
+	namespace impl{
+	// the calling thread's buffered streams, flushed when the thread exits
+	inline std::vector<std::unique_ptr<buffered_stream>> &thread_streams()
+	{
+		static thread_local std::vector<std::unique_ptr<buffered_stream>> streams;
+		return streams;
+	}
+	}
+
+	// the calling thread's buffered stream for a FILE*, created on first use
+	inline buffered_stream &thread_stream(FILE *fp)
+	{
+		std::vector<std::unique_ptr<buffered_stream>> &streams = impl::thread_streams();
+		for(const std::unique_ptr<buffered_stream> &stream : streams)
+			if(stream->file() == fp)
+				return *stream;
+
+		streams.emplace_back(new buffered_stream(fp));
+		return *streams.back();
+	}
+
+	#ifdef PRESS_HAS_FD
+	inline buffered_stream &thread_stream(int fd)
+	{
+		std::vector<std::unique_ptr<buffered_stream>> &streams = impl::thread_streams();
+		for(const std::unique_ptr<buffered_stream> &stream : streams)
+			if(stream->file() == NULL && stream->fd() == fd)
+				return *stream;
+
+		streams.emplace_back(new buffered_stream(fd));
+		return *streams.back();
+	}
+	#endif
+
+	// write out everything buffered by the calling thread's streams
+	inline void flush()
+	{
+		for(const std::unique_ptr<buffered_stream> &stream : impl::thread_streams())
+			stream->flush();
+	}
+
+	// writes print calls to a file in a compact binary form instead of formatting them: each compiled format string is written
+	// once, then each call only writes its format id and the raw values of its parameters. use press::decode_binary_log (or the
+	// press-decode tool) to turn the file into text later. a binary_log is not thread safe
+	class binary_log
+	{
+	public:
+		static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+		static constexpr uint32_t VERSION = 1;
+		static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+		// all lengths and ids are varints, see Parameter::encode
+		enum class Record : unsigned char
+		{
+			FORMAT = 1, // id, length, format string
+			ENTRY = 2, // id (0 when the format string follows inline), parameter count, parameters
+			ENTRY_NEWLINE = 3, // same as ENTRY, for println
+			TEXT = 4 // length, already formatted output
+		};
+
+		explicit binary_log(FILE *fp, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+			: m_fp(fp)
+			, m_buffer(buffer_size)
+			, m_used(0)
+		{
+			const uint32_t version = VERSION;
+			const uint32_t byte_order = BYTE_ORDER_MARK;
+			char *out = reserve(16);
+			memcpy(out, "PRESSLOG", 8);
+			memcpy(out + 8, &version, 4);
+			memcpy(out + 12, &byte_order, 4);
+		}
+
+		binary_log(const binary_log&) = delete;
+		binary_log &operator=(const binary_log&) = delete;
+
+		~binary_log()
+		{
+			flush();
+		}
+
+		template <typename... Ts> void print(const format_string &fmt, const Ts&... ts)
+		{
+			append(false, fmt, ts...);
+		}
+
+		template <typename... Ts> void println(const format_string &fmt, const Ts&... ts)
+		{
+			append(true, fmt, ts...);
+		}
+
+		void flush()
+		{
+			if(m_used > 0)
+				fwrite(m_buffer.data(), 1, m_used, m_fp);
+
+			m_used = 0;
+		}
+
+	private:
+		template <typename... Ts> void append(bool newline, const format_string &fmt, const Ts&... ts)
+		{
+			Parameter params[sizeof...(Ts) > 0 ? sizeof...(Ts) : 1];
+			impl::add_all(params, ts...);
+
+			bool encodable = true;
+			size_t size = 1 + Parameter::varint_size(sizeof...(Ts));
+			for(int i = 0; encodable && i < (int)sizeof...(Ts); ++i)
+			{
+				const size_t param_size = params[i].encoded_size();
+				encodable = param_size > 0;
+				size += param_size;
+			}
+
+			if(!encodable)
+			{
+				// format_to types can only be formatted now
+				m_scratch.clear();
+				{
+					Writer output(PrintTarget::STDSTRING, NULL, -1, &m_scratch, NULL, impl::estimate_size(fmt, sizeof...(Ts)));
+					impl::dispatch(output, fmt, impl::erased_args(params, sizeof...(Ts)));
+					if(newline)
+						output.write("\n", 1);
+				}
+
+				char *out = reserve(1 + Parameter::string_size(m_scratch.size()));
+				*out = (char)Record::TEXT;
+				Parameter::encode_string(out + 1, m_scratch.data(), m_scratch.size());
+				return;
+			}
+
+			size_t id = 0;
+			if(fmt.compiled != NULL)
+			{
+				id = fmt.compiled->id();
+				if(id >= m_defined.size() || !m_defined[id])
+					define(id, *fmt.compiled);
+			}
+			else
+				size += Parameter::string_size(strlen(fmt.fmt));
+			size += Parameter::varint_size(id);
+
+			char *out = reserve(size);
+			*out++ = (char)(newline ? Record::ENTRY_NEWLINE : Record::ENTRY);
+			out = Parameter::encode_varint(out, id);
+			if(fmt.compiled == NULL)
+				out = Parameter::encode_string(out, fmt.fmt, strlen(fmt.fmt));
+			out = Parameter::encode_varint(out, sizeof...(Ts));
+
+			for(int i = 0; i < (int)sizeof...(Ts); ++i)
+				out = params[i].encode(out);
+		}
+
+		void define(const size_t id, const compiled_format &cf)
+		{
+			if(id >= m_defined.size())
+				m_defined.resize(id + 1, false);
+			m_defined[id] = true;
+
+			char *out = reserve(1 + Parameter::varint_size(id) + Parameter::string_size(cf.fmt_len));
+			*out++ = (char)Record::FORMAT;
+			out = Parameter::encode_varint(out, id);
+			Parameter::encode_string(out, cf.fmt, cf.fmt_len);
+		}
+
+		// room for size more bytes, flushing first if needed
+		char *reserve(const size_t size)
+		{
+			if(m_used + size > m_buffer.size())
+			{
+				flush();
+				if(size > m_buffer.size())
+					m_buffer.resize(size);
+			}
+
+			char *const out = m_buffer.data() + m_used;
+			m_used += size;
+			return out;
+		}
+
+		FILE *const m_fp;
+		std::vector<char> m_buffer;
+		size_t m_used;
+		std::vector<bool> m_defined; // format ids already written to the file
+		std::string m_scratch;
+	};
 
-	template <typename... Ts> void print(const char *fmt, const Ts&... ts)
+	namespace impl{
+	inline bool read_exact(FILE *fp, void *data, size_t size)
 	{
-		impl::write(PrintTarget::FILE_P, stdout, NULL, NULL, 0, fmt, ts...);
+		return fread(data, 1, size, fp) == size;
 	}
 
-	template <typename... Ts> void println(const char *fmt, const Ts&... ts)
+	inline bool read_varint(FILE *fp, unsigned long long &u)
 	{
-		impl::write(PrintTarget::FILE_P, stdout, NULL, NULL, 0, fmt, ts...);
-		const char newline = '\n';
-		fwrite(&newline, 1, 1, stdout);
+		u = 0;
+		for(int shift = 0; shift < 64; shift += 7)
+		{
+			const int c = fgetc(fp);
+			if(c == EOF)
+				return false;
+
+			u |= (unsigned long long)(c & 0x7f) << shift;
+			if((c & 0x80) == 0)
+				return true;
+		}
+
+		return false;
 	}
 
-	template <typename... Ts> void fprint(FILE *fp, const char *fmt, const Ts&... ts)
+	inline bool read_string(FILE *fp, std::string &str)
 	{
-		impl::write(PrintTarget::FILE_P, fp, NULL, NULL, 0, fmt, ts...);
+		unsigned long long length;
+		if(!read_varint(fp, length) || length > UINT32_MAX)
+			return false;
+
+		str.resize(length);
+		return length == 0 || read_exact(fp, &str[0], length);
 	}
 
-	template <typename... Ts> void fprintln(FILE *fp, const char *fmt, const Ts&... ts)
+	inline bool read_parameter(FILE *fp, Parameter &param, std::string &storage)
 	{
-		impl::write(PrintTarget::FILE_P, fp, NULL, NULL, 0, fmt, ts...);
-		const char newline = '\n';
-		fwrite(&newline, 1, 1, fp);
+		const int header = fgetc(fp);
+		if(header == EOF)
+			return false;
+
+		signed char spec[2] = { -1, -1 };
+		if((header & Parameter::USER_SPEC) && !read_exact(fp, spec, 2))
+			return false;
+
+		const signed char w = spec[0];
+		const signed char p = spec[1];
+		unsigned long long value;
+		switch((Parameter::Type)(header & ~Parameter::USER_SPEC))
+		{
+			case Parameter::Type::STRING:
+				if(!read_string(fp, storage))
+					return false;
+				param.init(str_ref(storage.data(), storage.length()), w, p);
+				return true;
+			case Parameter::Type::CUSTOM:
+			{
+				std::string str;
+				if(!read_string(fp, str))
+					return false;
+				param.init(std::move(str), w, p);
+				return true;
+			}
+			case Parameter::Type::BOOLEAN_:
+			{
+				const int c = fgetc(fp);
+				param.init(c == 1, w, p);
+				return c != EOF;
+			}
+			case Parameter::Type::CHARACTER:
+			{
+				const int c = fgetc(fp);
+				param.init((char)c, w, p);
+				return c != EOF;
+			}
+			case Parameter::Type::SIGNED_INT:
+				if(!read_varint(fp, value))
+					return false;
+				param.init(Parameter::unzigzag(value), w, p);
+				return true;
+			case Parameter::Type::UNSIGNED_INT:
+				if(!read_varint(fp, value))
+					return false;
+				param.init(value, w, p);
+				return true;
+			case Parameter::Type::VOID_POINTER:
+				if(!read_varint(fp, value))
+					return false;
+				param.init((const void*)(uintptr_t)value, w, p);
+				return true;
+			case Parameter::Type::FLOAT64:
+			{
+				double d;
+				if(!read_exact(fp, &d, 8))
+					return false;
+				param.init(d, w, p);
+				return true;
+			}
+			case Parameter::Type::NONE:
+				return true;
+			default:
+				return false;
+		}
+	}
 	}
 
-	template <typename... Ts> void bprint(char *userbuffer, int userbuffer_size, const char *fmt, const Ts&... ts)
+	// turn a file written by press::binary_log back into text, formatted exactly as the print functions would have. returns
+	// false if the file is not a binary log written on a machine with the same byte order, or is truncated
+	inline bool decode_binary_log(FILE *in, FILE *out)
 	{
-		impl::write(PrintTarget::BUFFER, NULL, NULL, userbuffer, userbuffer_size, fmt, ts...);
+		char magic[8];
+		uint32_t version, byte_order;
+		if(!impl::read_exact(in, magic, 8) || memcmp(magic, "PRESSLOG", 8) != 0 || !impl::read_exact(in, &version, 4) || !impl::read_exact(in, &byte_order, 4))
+			return false;
+		if(version != binary_log::VERSION || byte_order != binary_log::BYTE_ORDER_MARK)
+			return false;
+
+		std::vector<std::string> formats;
+		std::string text;
+		std::vector<std::string> strings;
+		for(;;)
+		{
+			const int record = fgetc(in);
+			if(record == EOF)
+				return feof(in) != 0;
+
+			unsigned long long id;
+			if(record == (int)binary_log::Record::TEXT)
+			{
+				if(!impl::read_string(in, text))
+					return false;
+
+				fwrite(text.data(), 1, text.size(), out);
+				continue;
+			}
+			else if(!impl::read_varint(in, id) || id > UINT32_MAX)
+				return false;
+
+			if(record == (int)binary_log::Record::FORMAT)
+			{
+				if(id >= formats.size())
+					formats.resize(id + 1);
+				if(!impl::read_string(in, formats[id]))
+					return false;
+			}
+			else if(record == (int)binary_log::Record::ENTRY || record == (int)binary_log::Record::ENTRY_NEWLINE)
+			{
+				unsigned long long pack_size;
+				if(id == 0 ? !impl::read_string(in, text) : id >= formats.size())
+					return false;
+				if(!impl::read_varint(in, pack_size) || pack_size > 4096)
+					return false;
+
+				if(strings.size() < pack_size)
+					strings.resize(pack_size);
+				std::unique_ptr<Parameter[]> params(new Parameter[pack_size > 0 ? pack_size : 1]);
+				for(unsigned long long i = 0; i < pack_size; ++i)
+					if(!impl::read_parameter(in, params[i], strings[i]))
+						return false;
+
+				Writer output(PrintTarget::FILE_P, out, -1, NULL, NULL, 0);
+				impl::printer(id == 0 ? text.c_str() : formats[id].c_str(), impl::erased_args(params.get(), pack_size), output);
+				if(record == (int)binary_log::Record::ENTRY_NEWLINE)
+					output.write("\n", 1);
+			}
+			else
+				return false;
+		}
 	}
 
-	template <typename... Ts> void bprintln(char *userbuffer, int userbuffer_size, const char *fmt, const Ts&... ts)
+#ifdef PRESS_ASYNC
+	namespace impl{
+	// a bounded multi-producer single-consumer queue of captured print calls (after Dmitry Vyukov's bounded queue), drained by a
+	// background thread that does the formatting and writing. producers never lock or make syscalls
+	class async_logger
+	{
+	public:
+		static constexpr size_t SLOT_COUNT = 1024; // must be a power of 2
+		static constexpr int MAX_PARAMETERS = 8;
+		static constexpr int TEXT_SIZE = 256; // room for a runtime format string and string parameters
+		static constexpr size_t BATCH_SIZE = 64 * 1024;
+
+		struct slot
+		{
+			std::atomic<size_t> sequence;
+			FILE *fp;
+			const compiled_format *compiled; // only a persistent one (from prcompile), so it outlives the call
+			const char *fmt; // copied into text when compiled is NULL
+			int pack_size;
+			bool newline;
+			bool rendered; // already formatted by the caller into rendered_text
+			Parameter params[MAX_PARAMETERS];
+			char text[TEXT_SIZE];
+			std::string rendered_text;
+		};
+
+		static async_logger &instance()
+		{
+			static async_logger logger;
+			return logger;
+		}
+
+		// a slot to fill in, or NULL if the queue is full
+		slot *claim()
+		{
+			size_t pos = m_enqueue.load(std::memory_order_relaxed);
+			for(;;)
+			{
+				slot &s = m_slots[pos & (SLOT_COUNT - 1)];
+				const intptr_t diff = (intptr_t)s.sequence.load(std::memory_order_acquire) - (intptr_t)pos;
+
+				if(diff == 0)
+				{
+					if(m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						return &s;
+				}
+				else if(diff < 0)
+					return NULL;
+				else
+					pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+
+		// hand a claimed slot to the background thread
+		void publish(slot &s)
+		{
+			s.sequence.store(s.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		// wait until everything queued so far has been written
+		void wait()
+		{
+			const size_t target = m_enqueue.load(std::memory_order_acquire);
+			while(m_completed.load(std::memory_order_acquire) < target)
+				std::this_thread::yield();
+		}
+
+	private:
+		async_logger()
+			: m_slots(new slot[SLOT_COUNT])
+			, m_enqueue(0)
+			, m_completed(0)
+			, m_stop(false)
+		{
+			for(size_t i = 0; i < SLOT_COUNT; ++i)
+				m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+			m_thread = std::thread(&async_logger::run, this);
+		}
+
+		~async_logger()
+		{
+			m_stop.store(true, std::memory_order_release);
+			m_thread.join();
+		}
+
+		void run()
+		{
+			std::string batch;
+			FILE *batch_fp = NULL;
+			size_t dequeue = 0;
+			int idle = 0;
+
+			for(;;)
+			{
+				slot &s = m_slots[dequeue & (SLOT_COUNT - 1)];
+				if(s.sequence.load(std::memory_order_acquire) == dequeue + 1)
+				{
+					// consecutive calls to the same FILE* are written together
+					if(s.fp != batch_fp || batch.size() >= BATCH_SIZE)
+					{
+						write_batch(batch, batch_fp, dequeue);
+						batch_fp = s.fp;
+					}
+
+					format(s, batch);
+					s.sequence.store(dequeue + SLOT_COUNT, std::memory_order_release);
+					++dequeue;
+					idle = 0;
+					continue;
+				}
+
+				// the queue is empty
+				write_batch(batch, batch_fp, dequeue);
+				if(m_stop.load(std::memory_order_acquire))
+					return;
+
+				if(++idle < 64)
+					std::this_thread::yield();
+				else
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+
+		static void format(const slot &s, std::string &batch)
+		{
+			Writer output(PrintTarget::STDSTRING, NULL, -1, &batch, NULL, s.rendered ? s.rendered_text.size() : TEXT_SIZE);
+
+			if(s.rendered)
+				output.write(s.rendered_text.data(), s.rendered_text.size());
+			else if(s.compiled != NULL)
+				printer(*s.compiled, erased_args(s.params, s.pack_size), output);
+			else
+				printer(s.fmt, erased_args(s.params, s.pack_size), output);
+
+			if(s.newline)
+				output.write("\n", 1);
+		}
+
+		void write_batch(std::string &batch, FILE *fp, const size_t completed)
+		{
+			if(!batch.empty())
+				fwrite(batch.data(), 1, batch.size(), fp);
+
+			batch.clear();
+			m_completed.store(completed, std::memory_order_release);
+		}
+
+		const std::unique_ptr<slot[]> m_slots;
+		alignas(64) std::atomic<size_t> m_enqueue;
+		alignas(64) std::atomic<size_t> m_completed;
+		std::atomic<bool> m_stop;
+		std::thread m_thread;
+	};
+
+	template <typename... Ts> inline void write_async(FILE *fp, bool newline, const format_string &fmt, const Ts&... ts)
 	{
-		impl::write(PrintTarget::BUFFER, NULL, NULL, userbuffer, userbuffer_size, fmt, ts...);
-		if(userbuffer_size > 0)
+		async_logger &logger = async_logger::instance();
+		async_logger::slot *s = logger.claim();
+		if(s == NULL)
+		{
+		#ifdef PRESS_ASYNC_NO_WAIT
+			// the queue is full, rather than wait or lose the output, format it on this thread (it may then be written ahead of
+			// calls still in the queue)
+			write(PrintTarget::FILE_P, fp, -1, NULL, NULL, 0, newline, fmt, ts...);
+			return;
+		#else
+			// the queue is full, wait for the background thread to catch up so that the output stays in order
+			while((s = logger.claim()) == NULL)
+				std::this_thread::yield();
+		#endif
+		}
+
+		Parameter captured[sizeof...(Ts) > 0 ? sizeof...(Ts) : 1];
+		add_all(captured, ts...);
+
+		char *arena = s->text;
+		const char *const arena_end = s->text + async_logger::TEXT_SIZE;
+		bool detached = sizeof...(Ts) <= async_logger::MAX_PARAMETERS;
+
+		s->fp = fp;
+		s->newline = newline;
+		s->pack_size = sizeof...(Ts);
+		// any other compiled format may be gone by the time the background thread gets to it, so its text is copied like a
+		// plain format string's
+		s->compiled = fmt.compiled != NULL && fmt.compiled->persistent ? fmt.compiled : NULL;
+		if(s->compiled == NULL)
 		{
-			const int len = strlen(userbuffer);
-			if(len + 1 < userbuffer_size)
+			const size_t fmt_len = strlen(fmt.fmt) + 1;
+			detached = detached && fmt_len <= (size_t)(arena_end - arena);
+			if(detached)
 			{
-				userbuffer[len] = '\n';
-				userbuffer[len + 1] = 0;
+				memcpy(arena, fmt.fmt, fmt_len);
+				s->fmt = arena;
+				arena += fmt_len;
 			}
 		}
+
+		for(int i = 0; detached && i < (int)sizeof...(Ts); ++i)
+			detached = captured[i].detach_into(s->params[i], arena, arena_end);
+
+		// custom types and parameters that don't fit in the slot are formatted here instead
+		s->rendered = !detached;
+		if(s->rendered)
+		{
+			s->rendered_text.clear();
+			Writer output(PrintTarget::STDSTRING, NULL, -1, &s->rendered_text, NULL, estimate_size(fmt, sizeof...(Ts)));
+			dispatch(output, fmt, erased_args(captured, sizeof...(Ts)));
+		}
+
+		logger.publish(*s);
+	}
 	}
 
-	template <typename... Ts> std::string sprint(const char *fmt, const Ts&... ts)
+	// asynchronous printing: the parameters are captured into a queue and a background thread formats and writes them, so the
+	// calling thread only pays for copying them. string parameters are copied, custom types are formatted by the caller
+	template <typename... Ts> void aprint(const format_string &fmt, const Ts&... ts)
 	{
-		std::string output;
-		impl::write(PrintTarget::STDSTRING, NULL, &output, NULL, 0, fmt, ts...);
+		impl::write_async(stdout, false, fmt, ts...);
+	}
 
-		return output;
+	template <typename... Ts> void aprintln(const format_string &fmt, const Ts&... ts)
+	{
+		impl::write_async(stdout, true, fmt, ts...);
 	}
 
-	template <typename... Ts> std::string sprintln(const char *fmt, const Ts&... ts)
+	template <typename... Ts> void afprint(FILE *fp, const format_string &fmt, const Ts&... ts)
 	{
-		std::string output;
-		impl::write(PrintTarget::STDSTRING, NULL, &output, NULL, 0, fmt, ts...);
-		output.push_back('\n');
+		impl::write_async(fp, false, fmt, ts...);
+	}
 
-		return output;
+	template <typename... Ts> void afprintln(FILE *fp, const format_string &fmt, const Ts&... ts)
+	{
+		impl::write_async(fp, true, fmt, ts...);
+	}
+
+	// block until everything printed asynchronously so far has been written
+	inline void async_flush()
+	{
+		impl::async_logger::instance().wait();
 	}
+#endif
 }
 
 #endif // PRESS_H
@@ -1,10 +1,13 @@
 #include <string>
+#include <vector>
+#include <tuple>
 #include <stdlib.h>
 #include <time.h>
 
 struct my_custom_class
 {
 	my_custom_class() : t(time(NULL)) {}
+	my_custom_class(time_t tt) : t(tt) {}
 	const time_t t;
 };
 
@@ -18,6 +21,85 @@ namespace press
 
 #include "press.hpp"
 
+// a custom type that formats straight into the Writer, honoring the spec
+struct order_id
+{
+	unsigned long long id;
+};
+
+namespace press
+{
+	void format_to(press::Writer &writer, const order_id &o, const press::Format &format)
+	{
+		writer.write("ORD-", 4);
+		press::Converter::integer(writer, o.id, format, -1);
+	}
+}
+
+// a custom type holding a plain int, formatted with the integer converter
+struct celsius
+{
+	int degrees;
+};
+
+namespace press
+{
+	void format_to(press::Writer &writer, const celsius &c, const press::Format &format)
+	{
+		press::Converter::integer(writer, c.degrees, format, -1);
+		writer.write("C", 1);
+	}
+}
+
+// a custom type that draws length dashes, longer than the side buffer of an aligned field
+struct ruler
+{
+	int length;
+};
+
+namespace press
+{
+	void format_to(press::Writer &writer, const ruler &r, const press::Format&)
+	{
+		writer.fill('-', r.length);
+	}
+}
+
+// a custom type that formats itself through a nested runtime format
+struct nested_format
+{
+	const char *fmt;
+	int value;
+};
+
+namespace press
+{
+	void format_to(press::Writer &writer, const nested_format &n, const press::Format&)
+	{
+		const std::string inner = press::sprint(n.fmt, n.value);
+		writer.write(inner.data(), (int)inner.size());
+	}
+}
+
+// a sink that takes its output in pieces
+struct piece_sink
+{
+	std::string text;
+	int pieces;
+
+	void append(const char *data, size_t count)
+	{
+		text.append(data, count);
+		++pieces;
+	}
+};
+
+// what the printing macros' compile time check makes of fmt with parameters of types Ts
+template <typename... Ts> constexpr int check_specs(const char *fmt)
+{
+	return press::impl::check_format<press::impl::kind_list<Ts...>>(fmt, press::string_length(fmt), sizeof...(Ts));
+}
+
 static void tests();
 
 int main()
@@ -102,7 +184,7 @@ int main()
 }
 
 static int number = 1;
-template <typename... Ts> static void check(const char *expected, const char *fmt, const Ts&... ts)
+template <typename... Ts> static void check(const char *expected, const press::format_string &fmt, const Ts&... ts)
 {
 	const std::string got = press::sprint(fmt, ts...);
 	if(got != expected)
@@ -132,13 +214,461 @@ void tests()
 	check("this is a left-justified and thousands separated number: 1,225,225,225       ", "this is a left-justified and thousands separated number: {,-20}", 1225225225);
 	check("this signed integer has a blank space in front of it:  44 ", "this signed integer has a blank space in front of it: { -4}", 44);
 
+	check("this is a thousands separated negative number: -123 -1,234", "this is a thousands separated negative number: {,} {,}", -123, -1234);
+
+	// explicit locale conventions, with the grouping of the Indian numbering system
+	press::set_locale(press::locale_info(',', ".", "\3\2"));
+	check("locale: 1.23.45.678 -12.345 3,50", "locale: {,} {,} {.2}", 12345678, -12345, 3.5);
+	press::set_locale(press::locale_info('.', "'", "\3"));
+	check("locale: 1'234'567", "locale: {,}", 1234567);
+	press::refresh_locale();
+	check("locale: 1,234,567 3.5", "locale: {,} {.1}", 1234567, 3.5);
+
+	// padding for other types
+	check("[   abc][abc   ][ true][x  ]", "[{6}][{-6}][{5}][{-3}]", "abc", "abc", true, 'x');
+	check("[    -3.142][-3.142    ][-00003.142]", "[{10.3}][{-10.3}][{010.3}]", -3.14159, -3.14159, -3.14159);
+	check("[     hi]", "[{}]", press::set_width("hi", 7));
+
+	// fill characters and alignment
+	check("[abc***][***abc][*abc**][ abc  ]", "[{*<6}][{*>6}][{*^6}][{^6}]", "abc", "abc", "abc", "abc");
+	check("[..42..][42____][-3.14~~]", "[{.^6}][{_<6}][{~<7.2}]", 42, 42u, -3.14159);
+	check("[##0xff##][---beef][ true ]", "[{#^#x8}][{->x7}][{^6}]", 255u, 0xbeefu, true);
+	check("[00042][ 42  ]", "[{05}][{^05}]", 42, 42);
+	check("[==ORD-7===][ORD-00009][-c-]", "[{=^10}][{05}][{-^3}]", order_id{7}, order_id{9}, 'c');
+	check("[    1, 2    ]", "[{^}]", press::set_width(press::join(std::vector<int>{1, 2}), 12));
+
+	// wide argument lists
+	check("1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,a,b", "{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}",
+		1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, "a", std::string("b"));
+
+	// sinks
+	{
+		std::vector<char> chars(1, '>');
+		const int vector_length = press::format_to(chars, "{} {x} {}", 1, 255u, order_id{3});
+		std::string appended = "pre:";
+		press::format_to(appended, "{5}", 42);
+		piece_sink sink{"", 0};
+		const std::string big(3000, 'a');
+		const int sink_length = press::format_to(sink, "{}{}", big, 7);
+		std::vector<char> inserted;
+		press::format_to(std::back_inserter(inserted), "{}-{.1}", "ab", 3.5);
+		char raw[16];
+		*press::format_to(raw, "{}", order_id{9}) = 0;
+
+		if(vector_length != 10 || std::string(chars.begin(), chars.end()) != ">1 ff ORD-3" || appended != "pre:   42" || sink_length != 3001
+			|| sink.text != big + "7" || sink.pieces != 2 || std::string(inserted.begin(), inserted.end()) != "ab-3.5" || strcmp(raw, "ORD-9"))
+		{
+			fprintf(stderr, "error!! format_to wrote the wrong output\n");
+			exit(1);
+		}
+	}
+
+	// runtime built parameter lists
+	{
+		press::dynamic_args args;
+		const std::string text = "text";
+		for(int round = 0; round < 2; ++round)
+		{
+			args.clear();
+			args.push_back(1);
+			args.push_back(text);
+			args.push_back(press::set_width(2.5, 6));
+			args.push_back(my_custom_class(0));
+			for(int i = 0; i < 20; ++i)
+				args.push_back(i);
+
+			if(press::vsprint("{} {} [{.1}] {} {} {@24}", args) != "1 text [   2.5] the time is 0 0 19" || args.size() != 24)
+			{
+				fprintf(stderr, "error!! vsprint produced \"%s\"\n", press::vsprint("{} {} [{.1}] {} {} {@24}", args).c_str());
+				exit(1);
+			}
+		}
+
+		char small[8];
+		if(press::vbprint(small, sizeof(small), "{}-{}", args) != 6 || strcmp(small, "1-text"))
+		{
+			fprintf(stderr, "error!! vbprint produced \"%s\"\n", small);
+			exit(1);
+		}
+
+		// the join and hexdump wrappers are temporaries, the list keeps copies of them
+		const std::vector<int> values = {1, 2, 3};
+		const unsigned char raw[] = {0xab, 0xcd};
+		args.clear();
+		args.push_back(press::join(values, "+"));
+		args.push_back(press::hexdump(raw, sizeof(raw), ':'));
+		args.push_back(press::set_width(press::join(values), 3));
+		if(press::vsprint("{} {X} [{}]", args) != "1+2+3 AB:CD [  1,   2,   3]")
+		{
+			fprintf(stderr, "error!! vsprint of kept wrappers produced \"%s\"\n", press::vsprint("{} {X} [{}]", args).c_str());
+			exit(1);
+		}
+	}
+
+	// ranges
+	{
+		const std::vector<int> ints = {1, -20, 300};
+		const double doubles[] = {1.5, 2.75};
+		const std::vector<std::string> names = {"apple", "kiwi"};
+		check("[1, -20, 300] [1.50|2.75] [apple kiwi]", "[{}] [{.2}] [{}]", press::join(ints), press::join(doubles, "|"), press::join(names, " "));
+		check("[   1; -20]", "[{}]", press::set_width(press::join(ints.data(), 2, ";"), 4));
+		check("[]", "[{}]", press::join(std::vector<int>()));
+		check("1,a", prcompile("{}"), press::join(std::vector<std::string>{"1", "a"}, ","));
+
+		const std::string table = press::sprint_rows("{-6}|{5.1}|{}", names, doubles, ints);
+		if(table != "apple |  1.5|1\nkiwi  |  2.8|-20\n")
+		{
+			fprintf(stderr, "error!! print_rows produced \"%s\"\n", table.c_str());
+			exit(1);
+		}
+	}
+
 	// alternate bases
 	check("this right here (c) is a hexa-decimal number", "this right here ({x}) is a hexa-decimal number", 12u);
 	check("this right here (12) is an octal number", "this right here ({o}) is an octal number", 10u);
+	check("[0xff] [0XFF] [0x000000ff] [    0xff] [0xff    ] [010] [0]", "[{#x}] [{#X}] [{0#x10}] [{#x8}] [{-#x8}] [{#o}] [{#x}]", 255u, 255u, 255u, 255u, 255u, 8u, 0u);
+	check("[deadbeefcafef00d] [DEADBEEFCAFEF00D] [1]", "[{x}] [{X}] [{x}]", 0xdeadbeefcafef00dull, 0xdeadbeefcafef00dull, 1ull);
+
+	// pointers, in hex with the unsigned integer flags
+	check("[1234abcd] [0x1234abcd] [0X1234ABCD] [0x00001234abcd] [    1234abcd]", "[{}] [{#}] [{#X}] [{0#14}] [{}]", (const void*)0x1234abcd, (const void*)0x1234abcd, (const void*)0x1234abcd, (const void*)0x1234abcd, press::set_width((const void*)0x1234abcd, 12));
+
+	// byte buffers
+	{
+		unsigned char frame[40];
+		std::string expected, separated;
+		for(int i = 0; i < 40; ++i)
+		{
+			frame[i] = (unsigned char)(i * 37);
+			char digits[3];
+			snprintf(digits, sizeof(digits), "%02x", frame[i]);
+			expected += digits;
+			separated += (i > 0 ? ":" : "") + std::string(digits);
+		}
+
+		check(expected.c_str(), "{}", press::hexdump(frame, sizeof(frame)));
+		check(separated.c_str(), "{}", press::hexdump(frame, sizeof(frame), ':'));
+		check("[00 25 4A] [      00254a] [00254a      ] [00254A]", "[{X.3}] [{12}] [{-12}] [{X}]", press::hexdump(frame, 40, ' '), press::hexdump(frame, 3), press::hexdump(frame, 3), press::hexdump(frame, 3));
+	}
 
 	// strings
 	check("this is a string: coolio julio", "this is a string: {}", "coolio julio");
 	check("this is a std::string: coolio julio", "this is a std::string: {}", std::string("coolio julio"));
+	check("this is a str_ref: cool", "this is a str_ref: {}", press::str_ref("coolio julio", 4));
+	check("limited std::string: cool", "limited std::string: {.4}", std::string("coolio julio"));
+	if(press::sprint("embedded {}", std::string("a\0b", 3)) != std::string("embedded a\0b", 12))
+	{
+		fprintf(stderr, "error!! embedded NUL was lost\n");
+		exit(1);
+	}
+
+	// custom types
+	check("order ORD-42, ORD-00042, ORD-  7", "order {}, {05}, {}", order_id{42}, order_id{42}, press::set_width(order_id{7}, 3));
+	check("[-5C] [012C] [7C]", "[{}] [{03}] [{x}]", celsius{-5}, celsius{12}, celsius{7});
+	check("custom [the time is 0  ]", "custom [{-15}]", my_custom_class(0));
+
+	// floats
+	check("fixed: 3.141593 2.50 -0.000", "fixed: {} {.2} {.3}", 3.1415926, 2.499999, -0.0001);
+	check("rounds half to even: 0.12 2", "rounds half to even: {.2} {.0}", 0.125, 2.5);
+	check("big: 999999999999999945575230987042816.0", "big: {.1}", 1e33);
+	check("scientific: 1.234568e+04 1.5e-07 2e+00", "scientific: {e.6} {e} {e.0}", 12345.6789, 1.5e-7, 2.5);
+	check("shortest: 0.1 1e+16 123.456 1e-05 -0", "shortest: {g} {g} {g} {g} {g}", 0.1, 1e16, 123.456, 0.00001, -0.0);
+
+	// formatting into an existing string
+	std::string reused = "previous contents";
+	press::sprint_into(reused, "reused {} {}", 1, std::string(3000, 'x'));
+	if(reused != "reused 1 " + std::string(3000, 'x'))
+	{
+		fprintf(stderr, "error!! sprint_into produced the wrong string\n");
+		exit(1);
+	}
+	press::sprintln_into(reused, "short {}", 2);
+	check("short 2\n", "{}", reused);
+
+	// output lengths
+	char small[8];
+	const int needed = press::bprint(small, sizeof(small), "{} is too long", 123456);
+	if(needed != press::formatted_size("{} is too long", 123456) || needed != 18 || strcmp(small, "123456 ") != 0)
+	{
+		fprintf(stderr, "error!! expected a truncated \"123456 \" needing 18 bytes, got \"%s\" needing %d\n", small, needed);
+		exit(1);
+	}
+	if(press::bprintln(small, sizeof(small), "{}", 12345) != 6 || strcmp(small, "12345\n") != 0)
+	{
+		fprintf(stderr, "error!! bprintln didn't append the newline\n");
+		exit(1);
+	}
+	const int measured = prformatted_size("{05}", 3);
+	check("measured 5", "measured {}", measured);
+
+	// buffered streams only write when flushed
+	FILE *const buffered_file = tmpfile();
+	if(buffered_file != NULL)
+	{
+		char contents[32] = "";
+		{
+			press::buffered_stream stream(buffered_file, 1000);
+			stream.println("buffered {}", 1);
+			stream.print("buffered {}", 2);
+			fflush(buffered_file);
+			if(ftell(buffered_file) != 0)
+			{
+				fprintf(stderr, "error!! buffered_stream wrote before it was flushed\n");
+				exit(1);
+			}
+		}
+
+		rewind(buffered_file);
+		fread(contents, 1, sizeof(contents) - 1, buffered_file);
+		fclose(buffered_file);
+		check("buffered 1\nbuffered 2", "{}", contents);
+	}
+
+	// binary logs decode to the same text the print functions produce
+	FILE *const binary_file = tmpfile();
+	FILE *const decoded_file = tmpfile();
+	if(binary_file != NULL && decoded_file != NULL)
+	{
+		{
+			press::binary_log log(binary_file);
+			for(int i = 0; i < 2; ++i)
+				log.println(prcompile("binary {} {05} {x} {.2} {} {} {.3}"), -i, i, 255u, 0.5, 'c', true, std::string("coolio"));
+			log.print("runtime {} {-4}|", "format", order_id{5});
+		}
+
+		char contents[128] = "";
+		rewind(binary_file);
+		const bool decoded = press::decode_binary_log(binary_file, decoded_file);
+		rewind(decoded_file);
+		fread(contents, 1, sizeof(contents) - 1, decoded_file);
+		fclose(binary_file);
+		fclose(decoded_file);
+
+		if(!decoded)
+		{
+			fprintf(stderr, "error!! the binary log couldn't be decoded\n");
+			exit(1);
+		}
+		check("binary 0 00000 ff 0.50 c true coo\nbinary -1 00001 ff 0.50 c true coo\nruntime format ORD-5   |", "{}", contents);
+	}
+
+#ifdef PRESS_ASYNC
+	// asynchronous printing, with a string that is gone before the background thread formats it
+	FILE *const async_file = tmpfile();
+	if(async_file != NULL)
+	{
+		{
+			const std::string temporary = "temporary";
+			press::afprintln(async_file, "async {} {} {.2}", 1, temporary, 2.5);
+		}
+		{
+			// a compiled format that isn't from prcompile, gone (and its text reused) before it is formatted
+			char local_text[16] = "{} local";
+			const press::compiled_format_storage<4> local(local_text);
+			press::afprintln(async_file, local, 4);
+			strcpy(local_text, "{} reused");
+		}
+		prafprint(async_file, "{05} {}", 2, order_id{3});
+		press::async_flush();
+
+		char contents[64] = "";
+		rewind(async_file);
+		fread(contents, 1, sizeof(contents) - 1, async_file);
+		fclose(async_file);
+		check("async 1 temporary 2.50\n4 local\n00002 ORD-3", "{}", contents);
+	}
+#endif
+
+#ifdef PRESS_HAS_FD
+	// file descriptors, with a long argument that is passed to writev without being copied
+	int fds[2];
+	if(pipe(fds) == 0)
+	{
+		const std::string longarg(1000, 'z');
+		const int sent = press::dprintln(fds[1], "fd {} {}", 7, longarg);
+		close(fds[1]);
+
+		std::string received;
+		char chunk[512];
+		ssize_t got;
+		while((got = read(fds[0], chunk, sizeof(chunk))) > 0)
+			received.append(chunk, got);
+		close(fds[0]);
+
+		if(received != "fd 7 " + longarg + "\n" || sent != (int)received.size())
+		{
+			fprintf(stderr, "error!! dprintln wrote the wrong output\n");
+			exit(1);
+		}
+	}
+
+	// more long pieces between literals than writev takes at once
+	if(pipe(fds) == 0)
+	{
+		const std::string s(200, 'y');
+		const int sent = press::dprint(fds[1], "x{}x{}x{}x{}x{}x{}x{}x{}x", s, s, s, s, s, s, s, s);
+		close(fds[1]);
+
+		std::string received;
+		char chunk[512];
+		ssize_t got;
+		while((got = read(fds[0], chunk, sizeof(chunk))) > 0)
+			received.append(chunk, got);
+		close(fds[0]);
+
+		std::string expected = "x";
+		for(int i = 0; i < 8; ++i)
+			expected += s + "x";
+		if(received != expected || sent != (int)received.size())
+		{
+			fprintf(stderr, "error!! dprint of many long pieces wrote the wrong output\n");
+			exit(1);
+		}
+	}
+#endif
+
+	// long runtime formats, scanned in blocks
+	const std::string long_literal(70, '.');
+	check((long_literal + "1" + long_literal + "{2" + long_literal).c_str(), (long_literal + "{}" + long_literal + "{{}{}" + long_literal).c_str(), 1, 2);
+
+#ifdef PRESS_FORMAT_CACHE
+	// a cached runtime format whose buffer is reused for a different format
+	char reused_format[32] = "cached {} {}";
+	check("cached 1 2", reused_format, 1, 2);
+	check("cached 1 2", reused_format, 1, 2);
+	strcpy(reused_format, "{05} changed {}");
+	check("00003 changed 4", reused_format, 3, 4);
+
+#ifndef PRESS_FORMAT_CACHE_BY_CONTENT
+	// a nested runtime format that lands in the cache slot of the format that is still printing
+	{
+		static char outer[] = "outer [{}] {} done";
+		static char candidates[1024][16];
+		const auto slot = [](const char *fmt) { return (((unsigned long long)(uintptr_t)fmt * 11400714819323198485ull) >> 32) & (press::format_cache::ENTRY_COUNT - 1); };
+		char *inner = candidates[0];
+		for(int i = 0; i < 1024 && slot(inner) != slot(outer); ++i)
+			inner = candidates[i];
+		strcpy(inner, "inner {}");
+
+		check("outer [inner 5] 2 done", outer, nested_format{inner, 5}, 2);
+		check("outer [inner 6] 3 done", outer, nested_format{inner, 6}, 3);
+	}
+#endif
+#endif
+
+#ifdef PRESS_PARALLEL
+	// records formatted across threads come out in order, the same as formatting them one by one
+	{
+		std::vector<std::tuple<int, std::string, double>> records;
+		std::string expected;
+		for(int i = 0; i < 50000; ++i)
+		{
+			records.emplace_back(i, "name" + std::to_string(i % 7), i * 0.25);
+			press::format_to(expected, "{},{},{.2}\n", i, std::get<1>(records.back()), i * 0.25);
+		}
+
+		std::string output = "head\n";
+		const size_t written = press::parallel_format(output, "{},{},{.2}\n", records, 4);
+		std::string single;
+		press::parallel_format(single, prcompile("[{}]"), std::vector<int>{1, 2, 3}, 2);
+		if(written != expected.size() || output != "head\n" + expected || single != "[1][2][3]")
+		{
+			fprintf(stderr, "error!! parallel_format produced the wrong output\n");
+			exit(1);
+		}
+	}
+#endif
+
+#ifdef PRESS_STATS
+	// counters for a truncated buffer, a string, and a custom type with to_string
+	{
+		press::reset_stats();
+		char small[4];
+		press::bprint(small, sizeof(small), "{} {}", 12345, my_custom_class(0));
+		press::sprint("{}", 42);
+
+		const press::statistics stats = press::stats();
+		unsigned long long timed = 0;
+		for(int i = 0; i < press::statistics::LATENCY_BUCKETS; ++i)
+			timed += stats.latency[i];
+
+		if(stats.calls[(int)press::PrintTarget::BUFFER] != 1 || stats.bytes[(int)press::PrintTarget::BUFFER] != 19 || stats.truncations != 1
+			|| stats.calls[(int)press::PrintTarget::STDSTRING] != 1 || stats.bytes[(int)press::PrintTarget::STDSTRING] != 2 || stats.allocations != 1 || timed != 2)
+		{
+			fprintf(stderr, "error!! unexpected stats\n");
+			exit(1);
+		}
+	}
+
+	// aligned custom types are measured in scratch writers, which aren't counted
+	{
+		press::reset_stats();
+		const std::string centered = press::sprint("[{*^12}]", celsius{7});
+		const std::string long_field = press::sprint("[{*<10}]", ruler{300});
+
+		const press::statistics stats = press::stats();
+		if(centered != "[*****7C*****]" || long_field != "[" + std::string(300, '-') + "]" || stats.calls[(int)press::PrintTarget::BUFFER] != 0
+			|| stats.bytes[(int)press::PrintTarget::BUFFER] != 0 || stats.truncations != 0 || stats.calls[(int)press::PrintTarget::STDSTRING] != 2
+			|| stats.bytes[(int)press::PrintTarget::STDSTRING] != 316)
+		{
+			fprintf(stderr, "error!! unexpected stats for aligned custom types\n");
+			exit(1);
+		}
+	}
+#endif
+
+	// compiled formats
+	check("compiled: 42 and coolio", prcompile("compiled: {} and {}"), 42, "coolio");
+	check("compiled: {UNDEFINED}, 00031, 55  ", prcompile("compiled: {@0}, {05@1}, {-4@2}"), 31, 55);
+	check("literal brace check: { {} coolio {}}}  {{ !", prcompile("literal brace check: {{} {{}} {} {{}}}}  {{}{{} !"), "coolio");
+	check("unbalanced brackets  33}", prcompile("unbalanced brackets { {}"), 33);
+	check("malformed specifiers 33ello} 33oolio julio}", prcompile("malformed specifiers {hello} {coolio julio}"), 33, 33);
+
+	// trusted compiled formats, checked at compile time, print the same without the index checks
+	check("trusted: 55, 00031, 55  ", prcompile_trusted("trusted: {@2}, {05@1}, {-4@2}"), 31, 55);
+	{
+		char buffer[32];
+		prbprint(buffer, sizeof(buffer), "checked: {#x} {.2} {}", 255u, 0.5, "coolio");
+		if(strcmp(buffer, "checked: 0xff 0.50 coolio"))
+		{
+			fprintf(stderr, "error!! trusted compiled format printed \"%s\"\n", buffer);
+			exit(1);
+		}
+	}
+
+	// the compile time specifier checks
+	static_assert(check_specs<int, unsigned, double, const char*>("{} {0#x8} {e.3} {-10}") == press::impl::CHECK_OK, "valid specifiers");
+	static_assert(check_specs<void*, order_id, press::width_spec<unsigned>>("{#X} {x} {o}") == press::impl::CHECK_OK, "pointers, custom types and runtime width");
+	static_assert(check_specs<int, int>("{{} {@2} {} {@1}") == press::impl::CHECK_OK, "positional specifiers");
+	static_assert(check_specs<int>("{x}") == press::impl::CHECK_TYPE, "hex on a signed integer");
+	static_assert(check_specs<const char*>("{e}") == press::impl::CHECK_TYPE, "scientific on a string");
+	static_assert(check_specs<unsigned>("{#}") == press::impl::CHECK_TYPE, "alternate form without a base");
+	static_assert(check_specs<char*>("{x}") == press::impl::CHECK_TYPE, "hex on a mutable string");
+	static_assert(check_specs<char*, char*>("{-10} {*^8}") == press::impl::CHECK_OK, "mutable strings");
+	static_assert(check_specs<unsigned char*, const signed char*>("{x} {#X}") == press::impl::CHECK_OK, "byte pointers print as pointers");
+	static_assert(check_specs<int, int>("{} {} {}") == press::impl::CHECK_INDEX, "too few parameters");
+	static_assert(check_specs<int>("{@0}") == press::impl::CHECK_INDEX, "indices start at 1");
+	static_assert(check_specs<int>("{@2}") == press::impl::CHECK_INDEX, "index out of range");
+	static_assert(check_specs<unsigned>("{5x}") == press::impl::CHECK_MALFORMED, "representation after width");
+	static_assert(check_specs<unsigned>("{#0x}") == press::impl::CHECK_MALFORMED, "alternate form before padding");
+	static_assert(check_specs<int>("{200}") == press::impl::CHECK_MALFORMED, "width too large");
+	static_assert(check_specs<unsigned, const char*>("{*^#x10} {<5}") == press::impl::CHECK_OK, "fill and alignment");
+	static_assert(check_specs<int>("{^*5}") == press::impl::CHECK_MALFORMED, "fill after the alignment");
+
+#ifdef PRESS_HAS_CONSTEXPR_LOOPS
+	// long literals are past the recursion depth limit of the C++11 checks
+	{
+		#define PRESS_TEST_RUN "................................................................"
+		#define PRESS_TEST_RUNS PRESS_TEST_RUN PRESS_TEST_RUN PRESS_TEST_RUN PRESS_TEST_RUN PRESS_TEST_RUN PRESS_TEST_RUN PRESS_TEST_RUN PRESS_TEST_RUN
+		std::string text = prsprint(PRESS_TEST_RUNS "{}" PRESS_TEST_RUNS "{x}" PRESS_TEST_RUNS, 1, 255u);
+		if(text != PRESS_TEST_RUNS "1" PRESS_TEST_RUNS "ff" PRESS_TEST_RUNS)
+		{
+			fprintf(stderr, "error!! long checked format printed the wrong output\n");
+			exit(1);
+		}
+		#undef PRESS_TEST_RUNS
+		#undef PRESS_TEST_RUN
+	}
+#endif
 
 	fprintf(stderr, "============== all tests passed ==============\n");
 }
@@ -0,0 +1,43 @@
+// turns a log written by press::binary_log back into text
+// usage: press-decode <binary log> [output file]
+
+#include <stdio.h>
+
+#include "../press.hpp"
+
+int main(int argc, char **argv)
+{
+	if(argc < 2 || argc > 3)
+	{
+		press::fprintln(stderr, "usage: press-decode <binary log> [output file]");
+		return 1;
+	}
+
+	const char *const input_name = argv[1];
+	const char *const output_name = argc == 3 ? argv[2] : NULL;
+
+	FILE *in = fopen(input_name, "rb");
+	if(in == NULL)
+	{
+		press::fprintln(stderr, "press-decode: couldn't open \"{}\"", input_name);
+		return 1;
+	}
+
+	FILE *out = output_name != NULL ? fopen(output_name, "wb") : stdout;
+	if(out == NULL)
+	{
+		press::fprintln(stderr, "press-decode: couldn't open \"{}\"", output_name);
+		fclose(in);
+		return 1;
+	}
+
+	const bool success = press::decode_binary_log(in, out);
+	if(!success)
+		press::fprintln(stderr, "press-decode: \"{}\" is not a press binary log, or is truncated", input_name);
+
+	fclose(in);
+	if(out != stdout)
+		fclose(out);
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+// compares press's integer and float output against snprintf over edge cases and random values, and times both for every
+// case so that speed regressions are caught along with wrong output
+// usage: press-diff [--quick] [--save file] [--baseline file] [--tolerance fraction]
+// --save writes each case's press ns/op to file, --baseline fails any case that is more than tolerance (0.25 by default)
+// slower than in file. exits with 1 if any output differs or any case regressed
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../press.hpp"
+
+namespace
+{
+	enum Kind { SIGNED, UNSIGNED, FLOAT, SHORTEST };
+
+	// SHORTEST cases have no printf equivalent, their output must instead read back as the same value. they are timed
+	// against printf_fmt
+	struct Case
+	{
+		const char *name;
+		const char *press_fmt;
+		const char *printf_fmt;
+		Kind kind;
+	};
+
+	const Case cases[] =
+	{
+		{ "int", "{}", "%lld", SIGNED },
+		{ "int space", "{ }", "% lld", SIGNED },
+		{ "int width", "{12}", "%12lld", SIGNED },
+		{ "int zero pad", "{012}", "%012lld", SIGNED },
+		{ "int left", "{-12}", "%-12lld", SIGNED },
+		{ "unsigned", "{}", "%llu", UNSIGNED },
+		{ "hex", "{x}", "%llx", UNSIGNED },
+		{ "hex upper", "{X}", "%llX", UNSIGNED },
+		{ "hex prefix", "{#x}", "%#llx", UNSIGNED },
+		{ "hex padded", "{0#x18}", "%#018llx", UNSIGNED },
+		{ "octal", "{o}", "%llo", UNSIGNED },
+		{ "octal prefix", "{#o}", "%#llo", UNSIGNED },
+		{ "fixed", "{}", "%f", FLOAT },
+		{ "fixed .0", "{.0}", "%.0f", FLOAT },
+		{ "fixed .2", "{.2}", "%.2f", FLOAT },
+		{ "fixed .17", "{.17}", "%.17f", FLOAT },
+		{ "fixed width", "{12.3}", "%12.3f", FLOAT },
+		{ "fixed zero pad", "{012.3}", "%012.3f", FLOAT },
+		{ "fixed left", "{-12.3}", "%-12.3f", FLOAT },
+		{ "scientific .0", "{e.0}", "%.0e", FLOAT },
+		{ "scientific .6", "{e.6}", "%.6e", FLOAT },
+		{ "scientific .16", "{e.16}", "%.16e", FLOAT },
+		{ "shortest", "{g}", "%.17g", SHORTEST },
+		{ "shortest scientific", "{e}", "%.16e", SHORTEST },
+	};
+
+	struct Inputs
+	{
+		std::vector<long long> signed_values;
+		std::vector<unsigned long long> unsigned_values;
+		std::vector<double> float_values;
+	};
+
+	unsigned long long next_random(unsigned long long &state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	Inputs make_inputs(const int random_count)
+	{
+		Inputs in;
+		in.signed_values = { 0, 1, -1, 9, 10, -10, 99, 100, 999999999, 1000000000, -2147483647 - 1, 2147483647,
+			std::numeric_limits<long long>::min(), std::numeric_limits<long long>::max() };
+		in.unsigned_values = { 0, 1, 7, 8, 15, 16, 255, 256, 0xffffffffull, 0x100000000ull, std::numeric_limits<unsigned long long>::max() };
+		in.float_values = { 0.0, -0.0, 1.0, -1.0, 0.5, 0.125, 0.375, 2.5, 1e-300, 5e-324, 2.2250738585072014e-308, 1e15, 1e16, 1e21, 1e300,
+			std::numeric_limits<double>::max(), 0.1, 0.2, 0.3, 123.456, 1e-7, 9.5, 99.995, std::numeric_limits<double>::infinity(),
+			-std::numeric_limits<double>::infinity() };
+
+		unsigned long long state = 0x2545f4914f6cdd1dull;
+		for(int i = 0; i < random_count; ++i)
+		{
+			const unsigned long long bits = next_random(state);
+
+			// mixed magnitudes, so short numbers are as common as long ones
+			const int shift = bits % 64;
+			in.signed_values.push_back((long long)(next_random(state) >> shift) * (bits & 64 ? -1 : 1));
+			in.unsigned_values.push_back(next_random(state) >> shift);
+
+			// random bit patterns over every exponent (NaNs left out, their sign isn't portable), and "human" values
+			double d;
+			const unsigned long long float_bits = next_random(state);
+			memcpy(&d, &float_bits, sizeof(d));
+			if(d == d)
+				in.float_values.push_back(d);
+			in.float_values.push_back((double)(long long)(next_random(state) % 20000000 - 10000000) / 1000.0);
+		}
+
+		return in;
+	}
+
+	// the i'th input of the case's kind into either printer, returns the length
+	int press_one(char *buffer, const int size, const press::format_string &fmt, const Inputs &in, const Kind kind, const size_t i)
+	{
+		if(kind == SIGNED)
+			return press::bprint(buffer, size, fmt, in.signed_values[i]);
+		if(kind == UNSIGNED)
+			return press::bprint(buffer, size, fmt, in.unsigned_values[i]);
+		return press::bprint(buffer, size, fmt, in.float_values[i]);
+	}
+
+	int printf_one(char *buffer, const int size, const char *fmt, const Inputs &in, const Kind kind, const size_t i)
+	{
+		if(kind == SIGNED)
+			return snprintf(buffer, size, fmt, in.signed_values[i]);
+		if(kind == UNSIGNED)
+			return snprintf(buffer, size, fmt, in.unsigned_values[i]);
+		return snprintf(buffer, size, fmt, in.float_values[i]);
+	}
+
+	size_t input_count(const Inputs &in, const Kind kind)
+	{
+		return kind == SIGNED ? in.signed_values.size() : (kind == UNSIGNED ? in.unsigned_values.size() : in.float_values.size());
+	}
+
+	// the number of inputs where press and printf disagree, the first few are printed
+	int compare(const Case &c, const press::format_string &fmt, const Inputs &in)
+	{
+		int mismatches = 0;
+		char ours[512];
+		char theirs[512];
+		for(size_t i = 0; i < input_count(in, c.kind); ++i)
+		{
+			press_one(ours, sizeof(ours), fmt, in, c.kind, i);
+
+			bool same;
+			if(c.kind == SHORTEST)
+			{
+				const double value = in.float_values[i];
+				const double back = strtod(ours, NULL);
+				same = back == value && std::signbit(back) == std::signbit(value);
+				snprintf(theirs, sizeof(theirs), "%.17g", value);
+			}
+			else
+			{
+				printf_one(theirs, sizeof(theirs), c.printf_fmt, in, c.kind, i);
+				same = strcmp(ours, theirs) == 0;
+			}
+
+			if(!same && ++mismatches <= 5)
+				press::fprintln(stderr, "press-diff: {}: press printed \"{}\", printf printed \"{}\"", c.name, (const char*)ours, (const char*)theirs);
+		}
+
+		return mismatches;
+	}
+
+	// ns per call, over every input for at least seconds
+	template <typename F> double time_case(const size_t count, const double seconds, F f)
+	{
+		typedef std::chrono::steady_clock clock;
+		volatile int sink = 0;
+		unsigned long long calls = 0;
+		const clock::time_point start = clock::now();
+		double elapsed = 0;
+		do
+		{
+			for(size_t i = 0; i < count; ++i)
+				sink = sink + f(i);
+
+			calls += count;
+			elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		} while(elapsed < seconds);
+
+		return elapsed * 1e9 / calls;
+	}
+
+	std::map<std::string, double> load_baseline(const char *name)
+	{
+		std::map<std::string, double> baseline;
+		FILE *in = fopen(name, "r");
+		if(in == NULL)
+		{
+			press::fprintln(stderr, "press-diff: couldn't open \"{}\"", name);
+			exit(1);
+		}
+
+		// one "ns/op name" pair per line
+		char line[256];
+		while(fgets(line, sizeof(line), in) != NULL)
+		{
+			char *end;
+			const double ns = strtod(line, &end);
+			if(end == line || *end != ' ')
+				continue;
+
+			std::string case_name(end + 1);
+			while(!case_name.empty() && (case_name.back() == '\n' || case_name.back() == '\r'))
+				case_name.pop_back();
+			baseline[case_name] = ns;
+		}
+
+		fclose(in);
+		return baseline;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool quick = false;
+	const char *save_name = NULL;
+	const char *baseline_name = NULL;
+	double tolerance = 0.25;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--quick") == 0)
+			quick = true;
+		else if(strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+			save_name = argv[++i];
+		else if(strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+			baseline_name = argv[++i];
+		else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+			tolerance = atof(argv[++i]);
+		else
+		{
+			press::fprintln(stderr, "usage: press-diff [--quick] [--save file] [--baseline file] [--tolerance fraction]");
+			return 1;
+		}
+	}
+
+	const Inputs in = make_inputs(quick ? 2000 : 20000);
+	const double seconds = quick ? 0.02 : 0.3;
+	const std::map<std::string, double> baseline = baseline_name != NULL ? load_baseline(baseline_name) : std::map<std::string, double>();
+
+	FILE *save = NULL;
+	if(save_name != NULL && (save = fopen(save_name, "w")) == NULL)
+	{
+		press::fprintln(stderr, "press-diff: couldn't open \"{}\"", save_name);
+		return 1;
+	}
+
+	int failures = 0;
+	press::println("{-22} {>12} {>12} {>7} {>10} {>10}", "case", "press ns/op", "printf ns/op", "ratio", "mismatches", "baseline");
+	for(const Case &c : cases)
+	{
+		const press::compiled_format_storage<4> compiled(c.press_fmt);
+		const int mismatches = compare(c, compiled, in);
+
+		char buffer[512];
+		const size_t count = input_count(in, c.kind);
+		const double ours = time_case(count, seconds, [&](size_t i) { return press_one(buffer, sizeof(buffer), compiled, in, c.kind, i); });
+		const double theirs = time_case(count, seconds, [&](size_t i) { return printf_one(buffer, sizeof(buffer), c.printf_fmt, in, c.kind, i); });
+
+		const std::map<std::string, double>::const_iterator previous = baseline.find(c.name);
+		const bool regressed = previous != baseline.end() && ours > previous->second * (1 + tolerance);
+		if(previous != baseline.end())
+			press::println("{-22} {12.1} {12.1} {7.2} {10} {9.1}{}", c.name, ours, theirs, theirs / ours, mismatches, previous->second, regressed ? "!" : " ");
+		else
+			press::println("{-22} {12.1} {12.1} {7.2} {10} {>10}", c.name, ours, theirs, theirs / ours, mismatches, "-");
+
+		if(save != NULL)
+			press::fprintln(save, "{.2} {}", ours, c.name);
+
+		failures += mismatches > 0 || regressed;
+	}
+
+	if(save != NULL)
+		fclose(save);
+
+	if(failures > 0)
+	{
+		press::fprintln(stderr, "press-diff: {} cases failed", failures);
+		return 1;
+	}
+
+	return 0;
+}
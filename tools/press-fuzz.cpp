@@ -0,0 +1,122 @@
+// fuzzes Format::parse and impl::printer with arbitrary runtime format strings. every input is printed through each
+// interface, which must agree with each other on the output and its length
+// built with -fsanitize=fuzzer (PRESS_LIBFUZZER, see PRESS_FUZZ in CMakeLists.txt) this is a libFuzzer target. otherwise
+// usage: press-fuzz [input files...]
+// runs each input file once (for AFL, or to reproduce a crash), or with no files, a fixed number of generated formats
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../press.hpp"
+
+namespace
+{
+	const unsigned char bytes[] = { 0x00, 0x7f, 0x80, 0xff, 0x12, 0x34 };
+	const std::vector<int> numbers = { 1, -20, 300 };
+
+	void fail(const std::string &fmt, const char *what, const std::string &expected, const std::string &got)
+	{
+		fprintf(stderr, "press-fuzz: %s for format \"%s\"\nexpected: \"%s\"\ngot:      \"%s\"\n", what, fmt.c_str(), expected.c_str(), got.c_str());
+		abort();
+	}
+
+	template <typename... Ts> void run(const std::string &fmt, const Ts&... ts)
+	{
+		const std::string expected = press::sprint(fmt.c_str(), ts...);
+
+		const int size = press::formatted_size(fmt.c_str(), ts...);
+		if(size != (int)expected.size())
+			fail(fmt, "formatted_size disagrees with sprint", std::to_string(expected.size()), std::to_string(size));
+
+		// truncated into a small buffer, it's still the same output up to the buffer's end
+		char small[32];
+		const int needed = press::bprint(small, sizeof(small), fmt.c_str(), ts...);
+		if(needed != (int)expected.size() || expected.compare(0, sizeof(small) - 1, small) != 0)
+			fail(fmt, "bprint disagrees with sprint", expected, small);
+
+		// the compiled printer walks the format string the same way as the runtime one
+		const press::compiled_format_storage<512> compiled(fmt.c_str());
+		const std::string from_compiled = press::sprint(compiled, ts...);
+		if(from_compiled != expected)
+			fail(fmt, "compiled format disagrees with sprint", expected, from_compiled);
+
+		std::vector<char> appended;
+		press::format_to(appended, fmt.c_str(), ts...);
+		if(std::string(appended.begin(), appended.end()) != expected)
+			fail(fmt, "format_to disagrees with sprint", expected, std::string(appended.begin(), appended.end()));
+	}
+
+	void fuzz_one(const unsigned char *data, size_t size)
+	{
+		// the printers stop at a NUL like any C string, so do the same up front
+		const std::string fmt((const char*)data, strnlen((const char*)data, std::min(size, (size_t)4096)));
+
+		run(fmt, -42, 42u, -3.25, "text", 'c', true, (const void*)&bytes, std::string("string"), press::hexdump(bytes, sizeof(bytes), ':'), press::join(numbers),
+			1e300, -0.0, 18446744073709551615ull, press::set_width(7, 12), press::set_prec(2.5, 3));
+		run(fmt);
+		run(fmt, 0);
+	}
+}
+
+#ifdef PRESS_LIBFUZZER
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+	fuzz_one(data, size);
+	return 0;
+}
+#else
+int main(int argc, char **argv)
+{
+	if(argc > 1)
+	{
+		for(int i = 1; i < argc; ++i)
+		{
+			FILE *in = fopen(argv[i], "rb");
+			if(in == NULL)
+			{
+				press::fprintln(stderr, "press-fuzz: couldn't open \"{}\"", argv[i]);
+				return 1;
+			}
+
+			std::vector<unsigned char> input;
+			unsigned char chunk[4096];
+			size_t count;
+			while((count = fread(chunk, 1, sizeof(chunk), in)) > 0)
+				input.insert(input.end(), chunk, chunk + count);
+			fclose(in);
+
+			fuzz_one(input.data(), input.size());
+		}
+
+		return 0;
+	}
+
+	// formats built mostly from specifier characters, so that most of them reach deep into the parser
+	static const char alphabet[] = "{{{{}}}}<>^*#0-, xXoeg.@@0123456789abz";
+	unsigned long long state = 0x9e3779b97f4a7c15ull;
+	static const int ITERATIONS = 100000;
+	for(int i = 0; i < ITERATIONS; ++i)
+	{
+		unsigned char input[64];
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		const size_t length = state % sizeof(input);
+		for(size_t k = 0; k < length; ++k)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			input[k] = alphabet[state % (sizeof(alphabet) - 1)];
+		}
+
+		fuzz_one(input, length);
+	}
+
+	press::fprintln(stderr, "press-fuzz: {} generated formats passed", ITERATIONS);
+	return 0;
+}
+#endif